@@ -0,0 +1,216 @@
+#pragma once
+
+#include "spdlog/spdlog.h"
+#include "spdlog/details/os.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+//一条日志的紧凑二进制形式：格式串指针 + 未格式化的参数，字符串参数截断后拷贝进内联缓冲
+//格式串必须是字符串字面量（静态生存期），后台线程格式化时才去读它；仅支持"{}"占位
+struct LogRecord {
+    static const size_t MAX_ARGS = 8;
+    static const size_t TEXT_CAPACITY = 192;
+
+    enum class ArgType : uint8_t {
+        Int,
+        Uint,
+        Double,
+        Bool,
+        Text
+    };
+
+    struct Arg {
+        ArgType type;
+        bool truncated;     //Text被截断
+        union {
+            int64_t i;
+            uint64_t u;
+            double d;
+            struct {
+                uint16_t offset;
+                uint16_t length;
+            } text;
+        };
+    };
+
+    int64_t time_ns;        //system_clock，记录时刻而不是格式化时刻
+    const char* format;
+    size_t thread_id;
+    spdlog::level::level_enum level;
+    uint8_t arg_count;
+    uint16_t text_used;
+    Arg args[MAX_ARGS];
+    char text[TEXT_CAPACITY];
+};
+
+//单生产者单消费者的定长环形队列，每个写日志的线程一个，满了直接丢弃
+class LogQueue {
+public:
+    explicit LogQueue(size_t capacity);
+
+    //生产者：取一个空槽，填好后commit；队列满时返回nullptr
+    LogRecord* reserve();
+    void commit();
+
+    //消费者：取队首，处理完后pop
+    LogRecord* front();
+    void pop();
+
+    void countDropped() { dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    uint32_t sample_counters[spdlog::level::n_levels] = {};    //仅生产者线程访问
+
+private:
+    std::vector<LogRecord> records_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_;      //消费者位置
+    alignas(64) std::atomic<size_t> tail_;      //生产者位置
+    size_t cached_head_;                        //生产者缓存的消费者位置，减少跨核读取
+    std::atomic<uint64_t> dropped_;
+};
+
+//把格式化和写盘挪出事件循环的日志器，接口与spdlog::logger的info/debug/...一致
+//Async模式：调用线程只把参数打包进自己的LogQueue，后台线程统一格式化并写入spdlog的sinks
+//Sync模式：在调用线程上立即格式化并写入，便于调试
+//每个级别可设置采样率：1/N，按线程计数，N为1时不采样；采样只在Async模式下生效
+class AsyncLogger {
+public:
+    enum class Mode {
+        Sync,
+        Async
+    };
+
+    AsyncLogger(std::shared_ptr<spdlog::logger> sink_logger, Mode mode, size_t queue_capacity = 4096);
+    ~AsyncLogger();
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    //停止后台线程，把所有队列里剩余的记录写完
+    void stop();
+
+    void setLevel(spdlog::level::level_enum level) { level_.store(level, std::memory_order_relaxed); }
+    void setSampling(spdlog::level::level_enum level, uint32_t one_in);
+    Mode mode() const { return mode_; }
+    uint64_t dropped() const;
+
+    bool shouldLog(spdlog::level::level_enum level) const {
+        return level >= level_.load(std::memory_order_relaxed) && level != spdlog::level::off;
+    }
+
+    template <typename... Args>
+    void log(spdlog::level::level_enum level, const char* format, const Args&... args) {
+        static_assert(sizeof...(Args) <= LogRecord::MAX_ARGS, "too many log arguments");
+        if (!shouldLog(level)) {
+            return;
+        }
+
+        if (mode_ == Mode::Sync) {
+            LogRecord record;
+            std::string line;
+            fill(record, level, format, args...);
+            write(record, line);
+            return;
+        }
+
+        LogQueue* queue = localQueue();
+        uint32_t one_in = sampling_[level].load(std::memory_order_relaxed);
+        if (one_in > 1 && queue->sample_counters[level]++ % one_in != 0) {
+            return;
+        }
+        LogRecord* record = queue->reserve();
+        if (record == nullptr) {
+            queue->countDropped();
+            return;
+        }
+        fill(*record, level, format, args...);
+        queue->commit();
+    }
+
+    template <typename... Args>
+    void trace(const char* format, const Args&... args) { log(spdlog::level::trace, format, args...); }
+    template <typename... Args>
+    void debug(const char* format, const Args&... args) { log(spdlog::level::debug, format, args...); }
+    template <typename... Args>
+    void info(const char* format, const Args&... args) { log(spdlog::level::info, format, args...); }
+    template <typename... Args>
+    void warn(const char* format, const Args&... args) { log(spdlog::level::warn, format, args...); }
+    template <typename... Args>
+    void error(const char* format, const Args&... args) { log(spdlog::level::err, format, args...); }
+
+private:
+    template <typename... Args>
+    static void fill(LogRecord& record, spdlog::level::level_enum level, const char* format, const Args&... args) {
+        record.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        record.format = format;
+        record.thread_id = spdlog::details::os::thread_id();
+        record.level = level;
+        record.arg_count = 0;
+        record.text_used = 0;
+        (capture(record, args), ...);
+    }
+
+    static void captureText(LogRecord& record, std::string_view text);
+
+    template <typename T>
+    static void capture(LogRecord& record, const T& value) {
+        LogRecord::Arg& arg = record.args[record.arg_count++];
+        arg.truncated = false;
+        if constexpr (std::is_same_v<T, bool>) {
+            arg.type = LogRecord::ArgType::Bool;
+            arg.u = value ? 1 : 0;
+        } else if constexpr (std::is_enum_v<T>) {
+            arg.type = LogRecord::ArgType::Int;
+            arg.i = static_cast<int64_t>(value);
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            arg.type = LogRecord::ArgType::Int;
+            arg.i = value;
+        } else if constexpr (std::is_integral_v<T>) {
+            arg.type = LogRecord::ArgType::Uint;
+            arg.u = value;
+        } else if constexpr (std::is_floating_point_v<T>) {
+            arg.type = LogRecord::ArgType::Double;
+            arg.d = value;
+        } else {
+            record.arg_count--;
+            captureText(record, std::string_view(value));
+        }
+    }
+
+    LogQueue* localQueue();
+    size_t drain();
+    void write(const LogRecord& record, std::string& line);
+    void backgroundLoop();
+
+    std::shared_ptr<spdlog::logger> sink_logger_;
+    Mode mode_;
+    size_t queue_capacity_;
+    uint64_t instance_id_;      //区分线程本地缓存属于哪个日志器
+    std::atomic<spdlog::level::level_enum> level_;
+    std::atomic<uint32_t> sampling_[spdlog::level::n_levels];
+
+    mutable std::mutex queues_mutex_;
+    std::vector<std::unique_ptr<LogQueue>> queues_;     //只增不减，线程退出后其队列仍由日志器持有
+    std::unordered_map<std::thread::id, LogQueue*> thread_queues_;  //每个线程在本日志器上的队列，换回来时复用
+    std::atomic<size_t> queue_count_;
+
+    std::atomic<bool> running_;
+    std::thread worker_;
+    std::vector<LogQueue*> snapshot_;   //后台线程每轮遍历的队列
+    std::string line_;          //后台线程复用的格式化缓冲
+    uint64_t reported_dropped_;
+};
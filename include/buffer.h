@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <sys/uio.h>
+
+//定长内存块池，每个reactor一个，仅在所属线程内使用（不加锁）
+//内存按slab批量申请，归还的块挂在空闲链表上复用
+class BufferPool {
+public:
+    BufferPool(size_t block_size, size_t blocks_per_slab = 64);
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    char* acquire();
+    void release(char* block);
+
+    size_t blockSize() const { return block_size_; }
+    size_t freeBlocks() const { return free_list_.size(); }
+    size_t totalBlocks() const { return slabs_.size() * blocks_per_slab_; }
+
+private:
+    void grow();
+
+    size_t block_size_;
+    size_t blocks_per_slab_;
+    std::vector<std::unique_ptr<char[]>> slabs_;
+    std::vector<char*> free_list_;
+};
+
+//定容环形缓冲区，存储块在首次写入时从BufferPool借出，读空后可归还
+//head_/tail_为单调递增的计数，容量为2的幂时取模可用掩码代替
+class RingBuffer {
+public:
+    explicit RingBuffer(BufferPool* pool = nullptr);
+    ~RingBuffer();
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    RingBuffer(RingBuffer&& other) noexcept;
+    RingBuffer& operator=(RingBuffer&& other) noexcept;
+
+    size_t capacity() const { return capacity_; }
+    size_t readable() const { return tail_ - head_; }
+    size_t writable() const { return capacity_ - readable(); }
+    bool empty() const { return head_ == tail_; }
+    bool full() const { return readable() == capacity_; }
+
+    //借出存储块，成功后writable()不为0
+    bool reserve();
+    //缓冲区为空时把存储块还给池子
+    void releaseIfEmpty();
+
+    //可读/可写区域在环绕时分为两段，直接交给readv/writev，返回段数
+    int readableSegments(struct iovec iov[2]) const;
+    int writableSegments(struct iovec iov[2]);
+
+    //写入或读取了n字节后移动尾/头指针
+    void produce(size_t n) { tail_ += n; }
+    void consume(size_t n);
+
+    //可读区域中已确认不含帧边界的前缀长度，供按分隔符分帧的解析器从上次停下的位置继续查找；consume后清零
+    size_t scanned() const { return scanned_; }
+    void setScanned(size_t n) const { scanned_ = n; }
+
+    //可读区域跨越环绕点时在块内原地旋转，使其从块首开始连续存放，供需要连续内存的解析器使用
+    void linearize();
+
+    //从可读区域的offset处拷贝最多len字节，不消费，返回实际拷贝的字节数
+    size_t peek(size_t offset, char* dst, size_t len) const;
+
+    //拷贝写入，返回实际写入的字节数
+    size_t append(const char* data, size_t len);
+    size_t append(const RingBuffer& other);
+
+private:
+    size_t mask(size_t pos) const { return pos & (capacity_ - 1); }
+
+    BufferPool* pool_;
+    char* data_;
+    size_t capacity_;
+    size_t head_;
+    size_t tail_;
+    mutable size_t scanned_;
+};
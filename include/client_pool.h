@@ -0,0 +1,124 @@
+#pragma once
+
+#include "buffer.h"
+#include "codec.h"
+#include "epoll.h"
+#include "output_queue.h"
+#include "socket.h"
+#include "socket_address.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//客户端连接池：在少量预先建立的长连接上流水线发送分帧请求，省去每个请求一次握手和一个完整的往返
+//每条连接上的回复按发送顺序与请求一一对应；连接以非阻塞connect建立，握手完成由EPOLLOUT通知，超时后重连
+//全部操作在调用线程上进行，由poll驱动，不是线程安全的
+class ClientPool {
+public:
+    //ok为false表示请求没有得到回复（连接断开或无法建立），此时response为空
+    //response是输入缓冲上的视图，只在回调期间有效
+    using Callback = std::function<void(bool ok, std::string_view response)>;
+
+    enum class Framing {
+        Line,
+        LengthPrefixed
+    };
+
+    struct Options {
+        size_t connections = 4;
+        size_t pipeline = 64;           //每条连接上最多同时在途的请求，其余的在池中排队
+        int connect_timeout_ms = 3000;
+        int reconnect_delay_ms = 100;   //连接断开或握手失败后，隔多久再重连
+        Framing framing = Framing::Line;
+    };
+
+    ClientPool(const SocketAddress& target, const Options& options);
+    ~ClientPool();
+
+    ClientPool(const ClientPool&) = delete;
+    ClientPool& operator=(const ClientPool&) = delete;
+
+    //创建epoll并对全部连接发起非阻塞connect，不等待握手完成
+    bool start();
+
+    //交给已连上且在途最少的连接立即写出，都满了或都还在握手时排队；回调通常在poll中调用
+    //请求超过最大帧长，或写出时发现连接已断开，则在submit中直接以失败回调
+    void submit(std::string_view request, Callback callback);
+
+    //处理一轮就绪事件与超时，最多阻塞timeout_ms毫秒，返回本轮完成（含失败）的请求数
+    int poll(int timeout_ms);
+    //反复poll直到没有未完成的请求或超过timeout_ms，返回是否全部完成
+    bool drain(int timeout_ms);
+
+    //排队中与在途的请求数
+    size_t pending() const;
+    size_t connected() const;
+    uint64_t reconnects() const { return reconnects_; }
+
+    static const size_t BUFFER_SIZE = 16384;
+
+private:
+    enum class State {
+        Closed,
+        Connecting,
+        Ready
+    };
+
+    class Connection : public EpollHandler {
+    public:
+        Connection(ClientPool* pool, BufferPool* buffers) : input(buffers), output(buffers), pool_(pool) {}
+        void handleEvent(uint32_t events) override { pool_->handleEvent(*this, events); }
+
+        Socket socket;
+        State state = State::Closed;
+        uint64_t deadline_ms = 0;       //Connecting：握手超时时刻；Closed：下次重连时刻
+        RingBuffer input;
+        OutputQueue output;
+        std::deque<Callback> in_flight; //已写出（或已排入发送队列）等待回复的请求
+        bool want_write = false;
+
+    private:
+        ClientPool* pool_;
+    };
+
+    struct Queued {
+        std::string request;
+        Callback callback;
+    };
+
+    void handleEvent(Connection& conn, uint32_t events);
+    void connect(Connection& conn);
+    void onConnected(Connection& conn);
+    void readResponses(Connection& conn);
+    bool send(Connection& conn, std::string_view request);
+    void flush(Connection& conn);
+    void setWantWrite(Connection& conn, bool want);
+    void fail(Connection& conn, int error);
+    //把排队的请求分给有空位的连接
+    void dispatch();
+    Connection* pickReady();
+    //到期的握手超时与重连
+    void checkTimers();
+    int nextTimeout(int timeout_ms) const;
+    //没有正在握手或已连上的连接时，排队的请求不可能再被发出，全部以失败回调
+    void failQueuedIfUnreachable();
+    void complete(Callback& callback, bool ok, std::string_view response);
+
+    SocketAddress target_;
+    Options options_;
+    Epoll epoll_;
+    BufferPool buffers_;
+    std::unique_ptr<FrameCodec> codec_;
+    std::vector<std::unique_ptr<Connection>> conns_;
+    std::deque<Queued> queue_;
+    size_t in_flight_ = 0;
+    int completed_ = 0;         //本轮poll完成的请求数
+    uint64_t reconnects_ = 0;
+    std::vector<struct epoll_event> events_;
+};
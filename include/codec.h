@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <sys/uio.h>
+
+class RingBuffer;
+
+//解码出的一帧：payload是非拥有视图，在下一次decode或消费输入缓冲之前有效
+//wire_size为该帧在输入缓冲中占用的总字节数（含帧头/分隔符），处理完后由调用方consume
+struct Frame {
+    std::string_view payload;
+    size_t wire_size;
+};
+
+//分帧编解码器：直接在连接的输入缓冲上解析，不做逐帧分配
+//帧在环形缓冲区中连续时返回指向缓冲区的视图，只有跨越环绕点时才拷贝到内部的临时区
+class FrameCodec {
+public:
+    enum class DecodeResult {
+        Frame,      //解出一帧
+        NeedMore,   //数据不足
+        Error       //协议错误（如帧超长），应关闭连接
+    };
+
+    explicit FrameCodec(size_t max_frame) : max_frame_(max_frame) {}
+    virtual ~FrameCodec() = default;
+
+    virtual DecodeResult decode(const RingBuffer& input, Frame& frame) = 0;
+
+    //把payload编码为至多3段iovec（帧头、负载、帧尾），帧头/帧尾存放在编码器内部，到下一次encode前有效
+    virtual int encode(std::string_view payload, struct iovec iov[3]) = 0;
+    //负载不在内存中（例如用sendfile发送的文件）时只编码帧头和帧尾，没有的部分iov_len为0
+    //负载长度超出帧格式能表示的范围时返回false
+    virtual bool encodeEnvelope(size_t payload_len, struct iovec& header, struct iovec& trailer) = 0;
+
+    size_t maxFrame() const { return max_frame_; }
+
+protected:
+    //取输入缓冲中[offset, offset + len)的视图，跨越环绕点时拷贝
+    std::string_view view(const RingBuffer& input, size_t offset, size_t len);
+
+    size_t max_frame_;
+    std::vector<char> scratch_;
+};
+
+//4字节大端长度前缀 + 负载
+class LengthPrefixedCodec : public FrameCodec {
+public:
+    static const size_t HEADER_SIZE = 4;
+
+    explicit LengthPrefixedCodec(size_t max_frame) : FrameCodec(max_frame) {}
+
+    DecodeResult decode(const RingBuffer& input, Frame& frame) override;
+    int encode(std::string_view payload, struct iovec iov[3]) override;
+    bool encodeEnvelope(size_t payload_len, struct iovec& header, struct iovec& trailer) override;
+
+private:
+    char header_[HEADER_SIZE];
+};
+
+//以分隔符结尾的帧（默认换行），分隔符不属于负载
+class DelimiterCodec : public FrameCodec {
+public:
+    DelimiterCodec(size_t max_frame, char delimiter = '\n') : FrameCodec(max_frame), delimiter_(delimiter) {}
+
+    DecodeResult decode(const RingBuffer& input, Frame& frame) override;
+    int encode(std::string_view payload, struct iovec iov[3]) override;
+    bool encodeEnvelope(size_t payload_len, struct iovec& header, struct iovec& trailer) override;
+
+private:
+    char delimiter_;
+};
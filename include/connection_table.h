@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <vector>
+
+//按fd下标索引的连接表：连接对象在slab中成块预分配，关闭后经空闲链表复用
+//对象只在slab扩容时构造一次，之后的accept/close只在数组和空闲链表之间移动指针，不调用malloc
+//T需要提供 void recycle()：放回空闲链表前清理状态（关闭套接字、归还缓冲块、取消定时器等）
+template <typename T>
+class ConnectionTable {
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "slab storage is only default-aligned");
+
+public:
+    //construct在给定的存储上placement new一个对象，只在扩容时调用
+    using Constructor = std::function<T*(void* storage)>;
+
+    explicit ConnectionTable(Constructor construct, size_t objects_per_slab = 256)
+        : construct_(std::move(construct)), objects_per_slab_(objects_per_slab > 0 ? objects_per_slab : 1),
+          active_(0) {}
+
+    ~ConnectionTable() {
+        for (auto& slab : slabs_) {
+            for (size_t i = 0; i < slab.count; i++) {
+                slab.at(i)->~T();
+            }
+        }
+    }
+
+    ConnectionTable(const ConnectionTable&) = delete;
+    ConnectionTable& operator=(const ConnectionTable&) = delete;
+
+    //预先构造至少count个对象，并为最大fd预留下标
+    void reserve(size_t count, int max_fd = -1) {
+        while (capacity() < count) {
+            grow();
+        }
+        if (max_fd >= 0 && by_fd_.size() <= static_cast<size_t>(max_fd)) {
+            by_fd_.resize(static_cast<size_t>(max_fd) + 1, nullptr);
+        }
+    }
+
+    //为fd取一个空闲对象并登记到下标中
+    T* acquire(int fd) {
+        if (free_.empty()) {
+            grow();
+        }
+        T* obj = free_.back();
+        free_.pop_back();
+
+        if (by_fd_.size() <= static_cast<size_t>(fd)) {
+            by_fd_.resize(std::max(static_cast<size_t>(fd) + 1, by_fd_.size() * 2), nullptr);
+        }
+        by_fd_[fd] = obj;
+        active_++;
+        return obj;
+    }
+
+    //从下标中摘除，fd随后可被内核复用；对象本身要等recycle才回到空闲链表
+    void detach(int fd) {
+        if (fd >= 0 && static_cast<size_t>(fd) < by_fd_.size() && by_fd_[fd] != nullptr) {
+            by_fd_[fd] = nullptr;
+            active_--;
+        }
+    }
+
+    void recycle(T* obj) {
+        obj->recycle();
+        free_.push_back(obj);
+    }
+
+    T* find(int fd) const {
+        if (fd < 0 || static_cast<size_t>(fd) >= by_fd_.size()) {
+            return nullptr;
+        }
+        return by_fd_[fd];
+    }
+
+    size_t size() const { return active_; }
+    size_t capacity() const { return slabs_.size() * objects_per_slab_; }
+
+    template <typename F>
+    void forEach(F&& f) {
+        for (T* obj : by_fd_) {
+            if (obj != nullptr) {
+                f(*obj);
+            }
+        }
+    }
+
+private:
+    struct Slab {
+        std::unique_ptr<unsigned char[]> storage;
+        size_t count = 0;   //已构造的对象数
+
+        T* at(size_t i) { return std::launder(reinterpret_cast<T*>(storage.get() + i * sizeof(T))); }
+    };
+
+    //分配一整块存储并构造其中全部对象，加入空闲链表
+    void grow() {
+        Slab slab;
+        slab.storage.reset(new unsigned char[objects_per_slab_ * sizeof(T)]);
+        slabs_.push_back(std::move(slab));
+        Slab& s = slabs_.back();
+
+        free_.reserve(capacity());
+        for (size_t i = 0; i < objects_per_slab_; i++) {
+            construct_(s.storage.get() + i * sizeof(T));
+            s.count++;
+        }
+        for (size_t i = objects_per_slab_; i > 0; i--) {
+            free_.push_back(s.at(i - 1));
+        }
+    }
+
+    Constructor construct_;
+    size_t objects_per_slab_;
+    std::vector<Slab> slabs_;
+    std::vector<T*> free_;      //容量始终不小于对象总数，push_back不会重新分配
+    std::vector<T*> by_fd_;
+    size_t active_;
+};
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <utility>
+
+//协程帧分配器：每个事件循环一个，按大小分级缓存释放的帧，连接反复建立/关闭时不再走malloc
+//事件循环运行期间通过Scope登记为本线程的当前池，协程帧在创建时从当前池分配
+//帧头记录所属的池，释放时归还原池，因此帧必须在所属事件循环的线程上销毁（或该循环已停止之后）
+//没有当前池或帧超过最大级别时退回operator new
+class FramePool {
+public:
+    FramePool() = default;
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    //RAII：在作用域内把pool设为本线程的当前池
+    class Scope {
+    public:
+        explicit Scope(FramePool& pool) : previous_(current_) { current_ = &pool; }
+        ~Scope() { current_ = previous_; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        FramePool* previous_;
+    };
+
+    static void* allocate(size_t size);
+    static void deallocate(void* frame) noexcept;
+
+    size_t live() const { return live_; }       //尚未释放的帧
+    size_t reused() const { return reused_; }   //从缓存中取得的帧
+
+private:
+    //64B到4KB，每级翻倍
+    static const size_t MIN_CLASS_SHIFT = 6;
+    static const size_t CLASSES = 7;
+
+    //帧前的头部，保持16字节使帧本身仍按默认对齐
+    struct alignas(16) Header {
+        FramePool* owner;
+        uint32_t size_class;
+    };
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static thread_local FramePool* current_;
+
+    FreeBlock* free_[CLASSES] = {};
+    size_t live_ = 0;
+    size_t reused_ = 0;
+};
+
+//协程的返回类型：惰性启动，被co_await时才开始执行，结束后对称转移回等待者，嵌套调用不增长栈
+//一个Task只能被co_await一次；协程内未捕获的异常直接终止进程
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation;
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            std::coroutine_handle<> next = h.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() const noexcept { std::terminate(); }
+
+    static void* operator new(size_t size) { return FramePool::allocate(size); }
+    static void operator delete(void* frame) noexcept { FramePool::deallocate(frame); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    T value{};
+
+    Task<T> get_return_object() noexcept;
+    void return_value(T v) { value = std::move(v); }
+    T take() { return std::move(value); }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+    void take() const noexcept {}
+};
+
+}
+
+template <typename T>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    explicit Task(Handle handle) : handle_(handle) {}
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+        handle_.promise().continuation = caller;
+        return handle_;
+    }
+    T await_resume() { return handle_.promise().take(); }
+
+private:
+    Handle handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+}
+
+//即发即弃的协程：立即开始执行，结束时自行释放帧，没有人等待它的结果
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+
+        static void* operator new(size_t size) { return FramePool::allocate(size); }
+        static void operator delete(void* frame) noexcept { FramePool::deallocate(frame); }
+    };
+};
+
+//在当前线程上启动task，运行到第一个挂起点后返回
+inline Detached spawn(Task<> task) {
+    co_await task;
+}
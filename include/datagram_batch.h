@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+//一批数据报的收发槽位，配合recvmmsg/sendmmsg一次系统调用处理多个数据报
+//所有槽位的数据区、iovec、mmsghdr与地址在构造时一次性分配，之后反复复用
+class DatagramBatch {
+public:
+    DatagramBatch(size_t capacity = 64, size_t datagram_size = 2048);
+
+    DatagramBatch(const DatagramBatch&) = delete;
+    DatagramBatch& operator=(const DatagramBatch&) = delete;
+
+    size_t capacity() const { return capacity_; }
+    size_t datagramSize() const { return datagram_size_; }
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    bool full() const { return count_ == capacity_; }
+
+    //接收前复位全部槽位的长度与地址长度
+    void prepareReceive();
+    //接收后：第i个数据报的内容、长度与来源地址
+    std::string_view data(size_t i) const;
+    const struct sockaddr_storage& address(size_t i) const { return addrs_[i]; }
+
+    //发送前逐个追加（拷贝进槽位），超长或已满返回false
+    bool push(const char* data, size_t len, const struct sockaddr* addr, socklen_t addr_len);
+    //把收到的这一批原样作为待发送内容，发回各自的来源地址
+    void prepareReply();
+
+    void clear() { count_ = 0; }
+
+    struct mmsghdr* headers() { return headers_.get(); }
+    void setCount(size_t n) { count_ = n; }
+
+private:
+    size_t capacity_;
+    size_t datagram_size_;
+    size_t count_;
+    std::unique_ptr<char[]> storage_;
+    std::unique_ptr<struct iovec[]> iovs_;
+    std::unique_ptr<struct mmsghdr[]> headers_;
+    std::unique_ptr<struct sockaddr_storage[]> addrs_;
+};
@@ -1,10 +1,19 @@
 #pragma once
 
 #include <vector>
+#include <span>
 #include <cstdint>
 
 #include <sys/epoll.h>
 
+//事件处理者：注册时将其指针存入epoll_event.data.ptr，
+//事件到达后直接调用handleEvent，无需再按fd查表
+class EpollHandler {
+public:
+    virtual ~EpollHandler() = default;
+    virtual void handleEvent(uint32_t events) = 0;
+};
+
 class Epoll {
 public:
     Epoll();
@@ -13,18 +22,29 @@ public:
     bool create();
 
     bool add(int fd, uint32_t events);
+    bool add(int fd, uint32_t events, EpollHandler* handler);
 
     bool modify(int fd, uint32_t events);
+    bool modify(int fd, uint32_t events, EpollHandler* handler);
 
     bool remove(int fd);
 
-    std::vector<struct epoll_event> wait(int timeout = -1);
+    //便捷版本：每次分配结果数组，最多取回max_events个事件
+    std::vector<struct epoll_event> wait(int timeout = -1, int max_events = 1024);
+
+    //将就绪事件直接写入调用方持有的缓冲区，返回事件数（被信号中断时为0，出错为-1）
+    int wait(std::span<struct epoll_event> events, int timeout = -1);
+
+    //按data.ptr分发一批事件
+    static void dispatch(std::span<const struct epoll_event> events);
 
     int getFd() const { return epoll_fd_; }
 
     void close();
 
 private:
+    bool control(int op, int fd, struct epoll_event* ev);
+
     int epoll_fd_;
     bool is_created_;
 };
@@ -36,4 +56,5 @@ namespace EpollEvents {
     constexpr uint32_t HUP = EPOLLHUP;
     constexpr uint32_t ET = EPOLLET;
     constexpr uint32_t ONESHOT = EPOLLONESHOT;
+    constexpr uint32_t EXCLUSIVE = EPOLLEXCLUSIVE;
 }
\ No newline at end of file
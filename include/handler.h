@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <sys/types.h>
+
+//以文件内容作为回复正文：fd交给连接的发送队列，发完或连接关闭时关闭
+struct FileReply {
+    int fd = -1;
+    off_t offset = 0;
+    size_t length = 0;
+};
+
+//应用层消息处理接口：输入一条已分帧的完整消息，产出一条回复
+//handle可能在reactor线程上调用，也可能在工作线程池中调用，因此实现必须是线程安全的（通常是无状态的）
+class MessageHandler {
+public:
+    //Inline - 在reactor线程上直接处理；Offload - 交给工作线程池，完成后回到原reactor写出
+    enum class Dispatch {
+        Inline,
+        Offload
+    };
+
+    virtual ~MessageHandler() = default;
+
+    //按消息决定在哪里处理，廉价的请求留在reactor上，避免线程切换拖慢尾延迟
+    virtual Dispatch classify(std::string_view message) const { (void)message; return Dispatch::Inline; }
+
+    //返回回复内容：可以直接指向message（例如回显），也可以写入scratch后返回指向scratch的视图
+    virtual std::string_view handle(std::string_view message, std::string& scratch) const = 0;
+
+    //在handle之前调用：返回true表示回复正文是file描述的文件区间，由服务器用sendfile发送，不再调用handle
+    //只在reactor线程上调用，不支持文件回复的处理器保持默认实现
+    virtual bool openFile(std::string_view message, FileReply& file) const { (void)message; (void)file; return false; }
+    //回复总是文件时为true：HTTP前端据此把openFile失败回复为404，而不是调用handle
+    virtual bool servesFiles() const { return false; }
+
+    virtual const char* name() const = 0;
+};
+
+//回显：零拷贝地把请求原样作为回复
+class EchoHandler : public MessageHandler {
+public:
+    std::string_view handle(std::string_view message, std::string& scratch) const override;
+    const char* name() const override { return "echo"; }
+};
+
+//计算消息的CRC32并以8位十六进制返回，代表校验/压缩一类按字节计费的CPU工作
+//不小于offload_threshold字节的消息交给工作线程池
+class ChecksumHandler : public MessageHandler {
+public:
+    explicit ChecksumHandler(size_t offload_threshold = 4096) : offload_threshold_(offload_threshold) {}
+
+    Dispatch classify(std::string_view message) const override;
+    std::string_view handle(std::string_view message, std::string& scratch) const override;
+    const char* name() const override { return "checksum"; }
+
+    static uint32_t crc32(std::string_view data);
+
+private:
+    size_t offload_threshold_;
+};
+
+//静态文件：消息是相对于根目录的路径，回复是文件的完整内容，不经过用户态缓冲
+//拒绝绝对路径、".."、指向根目录之外的符号链接和非普通文件，打不开时回复"ERR not found"
+class FileHandler : public MessageHandler {
+public:
+    explicit FileHandler(const std::string& root);
+    ~FileHandler() override;
+
+    FileHandler(const FileHandler&) = delete;
+    FileHandler& operator=(const FileHandler&) = delete;
+
+    bool isValid() const { return root_fd_ != -1; }
+
+    bool openFile(std::string_view message, FileReply& file) const override;
+    bool servesFiles() const override { return true; }
+    std::string_view handle(std::string_view message, std::string& scratch) const override;
+    const char* name() const override { return "file"; }
+
+private:
+    int root_fd_;
+};
+
+//按名称创建处理器，未知名称返回nullptr；"file:目录"以该目录为根提供静态文件，"file"使用当前目录
+std::unique_ptr<MessageHandler> createHandler(const std::string& name);
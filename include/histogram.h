@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//HDR风格的对数-线性直方图：每个2的幂区间再等分为若干子桶，记录O(1)、无分配
+//相对误差约为 2 / 2^sub_bucket_bits，默认8位即约0.8%，可记录整个uint64范围
+//不加锁，每个线程各自记录，需要汇总时merge
+class Histogram {
+public:
+    explicit Histogram(int sub_bucket_bits = 8);
+
+    void record(uint64_t value);
+    void record(uint64_t value, uint64_t count);
+    void merge(const Histogram& other);
+    void reset();
+
+    uint64_t count() const { return count_; }
+    uint64_t min() const { return count_ == 0 ? 0 : min_; }
+    uint64_t max() const { return max_; }
+    uint64_t sum() const { return sum_; }
+    double mean() const { return count_ == 0 ? 0.0 : static_cast<double>(sum_) / static_cast<double>(count_); }
+
+    //p取[0, 100]，返回该分位所在桶的上界
+    uint64_t percentile(double p) const;
+
+    //按桶遍历非空桶（上界, 个数），用于导出
+    template <typename F>
+    void forEachBucket(F&& f) const {
+        for (size_t i = 0; i < counts_.size(); i++) {
+            if (counts_[i] != 0) {
+                f(upperBound(i), counts_[i]);
+            }
+        }
+    }
+
+private:
+    size_t indexOf(uint64_t value) const;
+    uint64_t upperBound(size_t index) const;
+
+    int sub_bucket_bits_;
+    uint64_t sub_bucket_count_;     //2^sub_bucket_bits
+    uint64_t half_count_;
+    std::vector<uint64_t> counts_;
+    uint64_t count_;
+    uint64_t sum_;
+    uint64_t min_;
+    uint64_t max_;
+};
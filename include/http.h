@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+//解析出的一个HTTP/1.x请求：各字段都是指向输入缓冲的非拥有视图，在消费输入缓冲之前有效
+struct HttpRequest {
+    static const size_t MAX_HEADERS = 32;
+
+    struct Header {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    std::string_view method;
+    std::string_view target;
+    std::string_view body;
+    int minor_version;          //HTTP/1.0为0，HTTP/1.1为1
+    bool keep_alive;            //按版本默认值和Connection头得出
+    Header headers[MAX_HEADERS];
+    size_t header_count;
+    size_t wire_size;           //请求行+头部+正文在输入中占用的总字节数
+
+    //按名称查找头部，名称不区分大小写，找不到返回空视图
+    std::string_view header(std::string_view name) const;
+    //去掉查询串后的路径
+    std::string_view path() const;
+};
+
+//增量HTTP/1.x请求解析器：在调用方给出的连续内存上原地解析，不拷贝、不分配
+//数据不足时返回NeedMore并记住已扫描到的位置，下次只扫描新到的数据；解出一个请求后调用方消费wire_size并reset
+//不支持分块编码的请求正文，遇到时按501处理
+class HttpParser {
+public:
+    enum class Result {
+        Complete,   //解出一个完整请求
+        NeedMore,   //数据不足
+        Error       //请求非法或超限，errorStatus()给出应回复的状态码，之后应关闭连接
+    };
+
+    explicit HttpParser(size_t max_request = 8192) : max_request_(max_request), scanned_(0), error_status_(0) {}
+
+    //data必须从请求的第一个字节开始
+    Result parse(std::string_view data, HttpRequest& request);
+    void reset() { scanned_ = 0; }
+
+    int errorStatus() const { return error_status_; }
+
+private:
+    Result fail(int status) {
+        error_status_ = status;
+        return Result::Error;
+    }
+
+    size_t max_request_;
+    size_t scanned_;            //已确认不含头部结束标记的前缀长度
+    int error_status_;
+};
+
+//把状态行和固定的几个响应头格式化到out中，返回写入的字节数；cap不足时返回0
+//HEAD请求同样按正文长度填写Content-Length，由调用方决定是否发送正文
+size_t formatHttpResponseHead(char* out, size_t cap, int status, std::string_view content_type,
+                              size_t content_length, bool keep_alive);
+
+const char* httpStatusReason(int status);
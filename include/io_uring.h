@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/io_uring.h>
+
+//io_uring的最小封装：直接使用系统调用与共享内存环，不依赖liburing
+//提交队列(SQ)与完成队列(CQ)都只由所属reactor线程访问
+class IoUring {
+public:
+    IoUring();
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    //内核不支持或被禁用io_uring时返回false，调用方可回退到epoll
+    bool init(unsigned entries);
+    void close();
+
+    int getFd() const { return ring_fd_; }
+    bool isValid() const { return ring_fd_ != -1; }
+
+    //取一个空闲的SQE（已清零），SQ已满时先提交再取，仍失败返回nullptr
+    struct io_uring_sqe* getSqe();
+
+    //提交全部待提交的SQE，并至少等待wait_nr个完成事件
+    int submitAndWait(unsigned wait_nr);
+    int submit() { return submitAndWait(0); }
+
+    //批量读取已完成的CQE，处理完后用advance归还给内核
+    unsigned peekCqes(struct io_uring_cqe** cqes, unsigned max);
+    void advance(unsigned n);
+
+    //常用操作的SQE填充
+    static void prepareAccept(struct io_uring_sqe* sqe, int fd, bool multishot, uint64_t user_data);
+    static void prepareRecv(struct io_uring_sqe* sqe, int fd, uint16_t buffer_group, bool multishot, uint64_t user_data);
+    static void prepareSend(struct io_uring_sqe* sqe, int fd, const void* data, size_t len, uint64_t user_data);
+    static void prepareCancel(struct io_uring_sqe* sqe, uint64_t target, uint64_t user_data);
+    static void prepareRead(struct io_uring_sqe* sqe, int fd, void* buf, size_t len, uint64_t user_data);
+
+private:
+    unsigned flushSq();
+
+    int ring_fd_;
+    unsigned features_;
+
+    void* sq_ptr_;
+    size_t sq_size_;
+    void* cq_ptr_;
+    size_t cq_size_;
+    struct io_uring_sqe* sqes_;
+    size_t sqes_size_;
+
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned* sq_mask_;
+    unsigned* sq_entries_;
+    unsigned* sq_array_;
+    unsigned sqe_head_;     //已分配但尚未提交的SQE区间[sqe_head_, sqe_tail_)
+    unsigned sqe_tail_;
+
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned* cq_mask_;
+    struct io_uring_cqe* cqes_;
+};
+
+//提供给内核的接收缓冲环（IORING_REGISTER_PBUF_RING）
+//多发接收(multishot recv)时由内核从环中挑选缓冲区，CQE中带回缓冲区编号
+class ProvidedBufferRing {
+public:
+    ProvidedBufferRing();
+    ~ProvidedBufferRing();
+
+    ProvidedBufferRing(const ProvidedBufferRing&) = delete;
+    ProvidedBufferRing& operator=(const ProvidedBufferRing&) = delete;
+
+    //count须为2的幂
+    bool init(IoUring& ring, uint16_t group_id, unsigned count, size_t buffer_size);
+    void close();
+
+    uint16_t groupId() const { return group_id_; }
+    size_t bufferSize() const { return buffer_size_; }
+    char* buffer(uint16_t bid) const { return buffers_ + static_cast<size_t>(bid) * buffer_size_; }
+
+    //把缓冲区还给内核；多次recycle后调用一次commit发布新的tail
+    void recycle(uint16_t bid);
+    void commit();
+
+private:
+    IoUring* ring_;
+    struct io_uring_buf_ring* br_;
+    size_t br_size_;
+    char* buffers_;
+    unsigned count_;
+    size_t buffer_size_;
+    uint16_t group_id_;
+    uint16_t tail_;
+    uint16_t pending_;
+};
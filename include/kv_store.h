@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//内存键值存储的一个分片：每个reactor一个，只由所属线程访问，不加锁
+//索引是线性探测的开放寻址哈希表，槽位只有8字节（32位哈希 + 条目引用），一个缓存行8个槽，探测时不访问条目本身
+//条目（头部+键+值）存放在按大小分级的1MB slab页中，每级有自己的空闲链表，不逐个malloc
+//页数达到内存上限后，从同级的条目中随机抽样，淘汰最久未访问的一个（近似LRU，已过期的优先）；
+//某一级一页都没有时，从页最多的一级整页收回
+class KvStore {
+public:
+    struct Stats {
+        uint64_t items = 0;
+        uint64_t memory_bytes = 0;  //已分配的slab页
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t expirations = 0;   //访问或抽样时发现已过期而删除的条目
+    };
+
+    //memory_limit向下取整到页，至少一页
+    explicit KvStore(size_t memory_limit);
+    ~KvStore();
+
+    KvStore(const KvStore&) = delete;
+    KvStore& operator=(const KvStore&) = delete;
+
+    //ttl_ms为0表示不过期；键为空或过长、条目超过一页时返回false
+    bool set(std::string_view key, std::string_view value, uint64_t ttl_ms, uint64_t now_ms);
+    //value指向分片中的数据，下一次修改前有效
+    bool get(std::string_view key, uint64_t now_ms, std::string_view& value);
+    bool erase(std::string_view key);
+    //remaining_ms为-1表示不过期
+    bool ttl(std::string_view key, uint64_t now_ms, int64_t& remaining_ms);
+    //ttl_ms为0表示取消过期
+    bool expire(std::string_view key, uint64_t ttl_ms, uint64_t now_ms);
+
+    //执行一条文本命令，回复写入scratch后返回其视图，或返回常量字符串：
+    //  GET key           -> VALUE <value> | NOT_FOUND
+    //  SET key value     -> STORED         值是key之后的全部字节，长度前缀分帧下可以是任意二进制
+    //  DEL key           -> DELETED | NOT_FOUND
+    //  TTL key           -> TTL <秒> | TTL -1（不过期） | NOT_FOUND
+    //  TTL key seconds   -> OK | NOT_FOUND  0表示取消过期
+    std::string_view execute(std::string_view command, uint64_t now_ms, std::string& scratch);
+
+    //是缓存命令时取出键（可能为空）并返回true；用于在执行前按键选择分片
+    static bool parseKey(std::string_view command, std::string_view& key);
+    static uint64_t hashKey(std::string_view key);
+
+    Stats stats() const;
+
+    static const size_t PAGE_SIZE = 1024 * 1024;
+    static const size_t MAX_KEY = 250;
+
+private:
+    //块的头部，键和值紧随其后；空闲时键的位置存放空闲链表的next指针
+    struct Item {
+        uint64_t expires_ms;    //0表示不过期
+        uint32_t hash;
+        uint32_t ref;           //所在页与块号，与槽位中的引用相同
+        uint32_t value_len;
+        uint32_t access;        //最近一次访问时的逻辑时钟
+        uint16_t key_len;
+        uint8_t cls;
+        uint8_t live;
+
+        char* key() { return reinterpret_cast<char*>(this + 1); }
+        char* value() { return key() + key_len; }
+        Item*& next() { return *reinterpret_cast<Item**>(this + 1); }
+    };
+
+    struct Slot {
+        uint32_t hash;
+        uint32_t ref;
+    };
+
+    struct Page {
+        std::unique_ptr<char[]> base;
+        uint8_t cls;
+    };
+
+    struct SizeClass {
+        size_t size;
+        uint32_t per_page;
+        Item* free_list = nullptr;
+        std::vector<uint32_t> pages;
+    };
+
+    static const uint32_t EMPTY = UINT32_MAX;
+    static const uint32_t BLOCK_BITS = 16;
+    static const size_t INITIAL_SLOTS = 1024;
+    static const int EVICTION_SAMPLES = 5;
+
+    Item* resolve(uint32_t ref) {
+        const Page& page = pages_[ref >> BLOCK_BITS];
+        return reinterpret_cast<Item*>(page.base.get() + (ref & ((1u << BLOCK_BITS) - 1)) * classes_[page.cls].size);
+    }
+    bool expired(const Item* item, uint64_t now_ms) const { return item->expires_ms != 0 && item->expires_ms <= now_ms; }
+
+    //返回槽位下标，没有时返回SIZE_MAX
+    size_t find(std::string_view key, uint32_t hash);
+    //找到未过期的条目并更新访问时间，过期的顺便删除
+    Item* lookup(std::string_view key, uint64_t now_ms);
+    void insertSlot(uint32_t hash, uint32_t ref);
+    //删除槽位后把后面同一探测链上的槽位前移，不留墓碑
+    void eraseSlot(size_t index);
+    size_t slotOf(const Item* item);
+    void remove(Item* item);
+    void grow();
+
+    size_t classFor(size_t size) const;
+    //空闲链表为空且不能再加页时，先淘汰或收回一页
+    Item* allocate(uint8_t cls, uint64_t now_ms);
+    void free(Item* item);
+    //把一页切成块放进该级的空闲链表
+    void format(uint32_t page_index, uint8_t cls);
+    bool addPage(uint8_t cls);
+    //淘汰cls级中抽样到的最旧条目
+    void evict(uint8_t cls, uint64_t now_ms);
+    //cls级一页都没有：从页最多的一级收回一页，其上的条目全部淘汰
+    bool stealPage(uint8_t cls);
+    uint32_t random();
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+    size_t items_;
+    std::vector<SizeClass> classes_;
+    std::vector<Page> pages_;
+    size_t max_pages_;
+    uint32_t clock_;
+    uint64_t seed_;
+    Stats stats_;           //items与memory_bytes在stats()中填写
+};
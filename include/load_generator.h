@@ -0,0 +1,56 @@
+#pragma once
+
+#include "histogram.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//压测参数
+struct LoadGeneratorOptions {
+    enum class Framing {
+        Raw,            //原样字节，回显长度与请求相同
+        Line,           //负载后附加换行
+        LengthPrefixed  //4字节大端长度前缀
+    };
+
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    int connections = 100;      //总连接数，平均分给各线程
+    int threads = 1;
+    size_t message_size = 64;   //负载字节数（不含帧头/分隔符）
+    int pipeline = 1;           //每个连接最多同时在途的请求数
+    double rate = 0;            //总请求速率（条/秒），0表示闭环：收到一条回复再发下一条
+    double duration = 10;       //计时阶段的秒数
+    double warmup = 1;          //预热秒数，期间的样本不计入统计
+    Framing framing = Framing::Raw;
+};
+
+//压测结果，各线程的结果merge后输出
+struct LoadGeneratorResult {
+    Histogram latency_us;       //请求延迟（微秒）
+    uint64_t sent = 0;
+    uint64_t completed = 0;
+    uint64_t bytes = 0;
+    uint64_t errors = 0;
+    double elapsed = 0;         //计时阶段实际耗时（秒）
+
+    void merge(const LoadGeneratorResult& other);
+};
+
+//基于Epoll的非阻塞压测客户端：每个线程一个Epoll，驱动成百上千个连接
+//开环模式下按计划时间计算延迟（而不是实际发出时间），避免协调遗漏（coordinated omission）
+class LoadGenerator {
+public:
+    explicit LoadGenerator(const LoadGeneratorOptions& options) : options_(options) {}
+
+    //运行全部线程并汇总结果
+    bool run(LoadGeneratorResult& result);
+
+    static void printReport(const LoadGeneratorOptions& options, const LoadGeneratorResult& result);
+
+private:
+    bool runWorker(int index, int connections, LoadGeneratorResult& result);
+
+    LoadGeneratorOptions options_;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "histogram.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+//单个reactor线程的运行指标：只由所属线程修改，用普通整数，热路径上没有原子操作和锁
+//采集时通过任务队列在所属线程上复制一份快照（顺便计算连接数、队列深度等瞬时值），再交给导出方
+struct LoopMetrics {
+    //累计计数
+    uint64_t accepts = 0;
+    uint64_t accept_errors = 0;
+    uint64_t closes = 0;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    uint64_t read_calls = 0;
+    uint64_t read_eagain = 0;
+    uint64_t write_calls = 0;
+    uint64_t write_eagain = 0;
+    uint64_t short_writes = 0;      //一次写没能写完、剩余部分进入发送队列
+    uint64_t wait_calls = 0;
+    uint64_t events = 0;
+    uint64_t messages = 0;
+    uint64_t offloaded = 0;
+    uint64_t tasks = 0;             //执行的跨线程任务数
+    uint64_t upstream_connects = 0;         //代理模式下向后端发起（或从预连接池取用）的连接
+    uint64_t upstream_pool_hits = 0;        //其中来自预连接池的
+    uint64_t upstream_failures = 0;         //握手失败或超时
+    uint64_t proxied_bytes = 0;             //两个方向经splice转发的字节数
+    uint64_t published = 0;                 //本reactor上收到的PUB
+    uint64_t fanout_deliveries = 0;         //排入订阅者发送队列的消息
+    uint64_t fanout_drops = 0;              //因订阅者太慢而丢弃的消息
+    uint64_t slow_disconnects = 0;          //因太慢而被断开的订阅者
+    uint64_t cache_forwarded = 0;           //键属于其他reactor的分片、转交过去执行的缓存命令
+    uint64_t cache_hits = 0;                //以下由本reactor的缓存分片统计
+    uint64_t cache_misses = 0;
+    uint64_t cache_evictions = 0;
+    uint64_t cache_expirations = 0;
+
+    //快照时刻的瞬时值
+    uint64_t active_connections = 0;
+    uint64_t output_queue_bytes = 0;
+    uint64_t deferred_messages = 0;
+    uint64_t paused_connections = 0;
+    uint64_t subscriptions = 0;
+    uint64_t cache_items = 0;
+    uint64_t cache_memory_bytes = 0;
+
+    //分布
+    Histogram events_per_wait;
+    Histogram loop_us;              //一轮事件循环（不含阻塞等待）的耗时
+    Histogram handler_us;           //在reactor线程上处理一条消息的耗时
+    Histogram offload_us;           //转交线程池的消息从提交到结果回到reactor的耗时
+};
+
+//Prometheus文本格式（0.0.4）：计数与瞬时值按reactor标签逐个输出，分布导出为summary
+//globals为不属于某个reactor的瞬时值，例如线程池队列深度
+std::string formatPrometheus(const std::vector<LoopMetrics>& reactors,
+                             const std::vector<std::pair<std::string, uint64_t>>& globals,
+                             const std::string& prefix = "epoll_server");
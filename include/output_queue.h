@@ -0,0 +1,79 @@
+#pragma once
+
+#include "buffer.h"
+#include "shared_buffer.h"
+
+#include <cstddef>
+#include <deque>
+
+#include <sys/types.h>
+
+class Socket;
+
+//连接的发送队列：由池中借出的环形缓冲块组成，保存套接字暂时写不下的数据
+//写满时由调用方注册EPOLLOUT，可写后flush，队列长度用于高低水位背压
+//除内存块外还可以排入共享缓冲区的引用（广播时多个队列共用一份数据，不拷贝）、文件区间和管道中的数据，flush时用sendfile/splice直接发送，与内存数据保持先后顺序
+class OutputQueue {
+public:
+    explicit OutputQueue(BufferPool* pool);
+    ~OutputQueue();
+
+    OutputQueue(const OutputQueue&) = delete;
+    OutputQueue& operator=(const OutputQueue&) = delete;
+
+    //尚未发出的字节数，包括排队的文件/管道数据
+    size_t size() const { return bytes_; }
+    bool empty() const { return bytes_ == 0; }
+
+    //拷贝追加，按需从池中借出新块
+    void append(const char* data, size_t len);
+    //整块接管：数据较少且尾块放得下时拷贝，否则直接挂入队列，不拷贝
+    void append(RingBuffer&& buffer);
+    //排入文件中[offset, offset + len)的内容，发送进度记在队列里，每次可写时从上次停下的位置继续
+    //owns_fd为true时发完或clear时关闭fd
+    void appendFile(int fd, off_t offset, size_t len, bool owns_fd = true);
+    //排入管道中已有的len字节；管道必须已装有这些数据，否则flush会把管道读空误当作套接字写满
+    void appendPipe(int fd, size_t len, bool owns_fd = false);
+    //排入共享缓冲区中[offset, offset + len)的引用，len为0时到缓冲区末尾；与内存块一起用writev发送
+    void appendShared(SharedBuffer buffer, size_t offset = 0, size_t len = 0);
+
+    //尽量多地写入套接字，返回写出的字节数；遇到EAGAIN返回已写出的部分，出错返回-1
+    //每次writev聚集最多MAX_FLUSH_CHUNKS个内存块；文件在发送前被截断时按出错处理（errno为EIO）
+    ssize_t flush(Socket& socket);
+
+    void clear();
+
+private:
+    static const size_t MAX_FLUSH_CHUNKS = 32;
+
+    enum class Kind {
+        Memory,
+        Shared,
+        File,
+        Pipe
+    };
+
+    struct Segment {
+        Kind kind;
+        RingBuffer chunk;       //Memory
+        SharedBuffer shared;    //Shared
+        int fd;                 //File/Pipe
+        off_t offset;           //File/Shared：下一个要发送的位置
+        size_t remaining;       //Shared/File/Pipe：剩余字节数
+        bool owns_fd;
+
+        explicit Segment(BufferPool* pool)
+            : kind(Kind::Memory), chunk(pool), fd(-1), offset(0), remaining(0), owns_fd(false) {}
+    };
+
+    static bool inMemory(const Segment& seg) { return seg.kind == Kind::Memory || seg.kind == Kind::Shared; }
+
+    ssize_t flushMemory(Socket& socket, bool& blocked);
+    ssize_t flushDescriptor(Socket& socket, bool& blocked);
+    void consume(size_t n);
+    void popFront();
+
+    BufferPool* pool_;
+    std::deque<Segment> segments_;
+    size_t bytes_;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+//splice用的中转管道：两端都是非阻塞的，buffered记录管道中尚未搬走的字节数
+//splice在管道写满和套接字无数据时都返回EAGAIN，只能靠buffered与capacity判断是哪一种
+struct Pipe {
+    int read_fd = -1;
+    int write_fd = -1;
+    size_t capacity = 0;
+    size_t buffered = 0;
+
+    bool isOpen() const { return read_fd != -1; }
+    size_t room() const { return capacity - buffered; }
+};
+
+//每个reactor一个管道池：管道只在一个方向上有数据在途时才被占用，排空后立即归还
+//空闲连接因此不占管道的fd，转发大量短连接时也不必反复pipe2/close
+//只由所属reactor线程访问
+class PipePool {
+public:
+    //max_idle为最多缓存的空闲管道数；pipe_size不为0时用F_SETPIPE_SZ调整新管道的容量
+    explicit PipePool(size_t max_idle, int pipe_size = 0);
+    ~PipePool();
+
+    PipePool(const PipePool&) = delete;
+    PipePool& operator=(const PipePool&) = delete;
+
+    //取一个空闲管道，没有时新建；失败（fd耗尽）返回false并保留errno
+    bool acquire(Pipe& pipe);
+    //归还：空的管道放回池中，仍有数据的（连接中途关闭）直接关闭，不能留给下一个连接
+    void release(Pipe& pipe);
+
+    size_t idle() const { return idle_.size(); }
+    size_t created() const { return created_; }
+
+private:
+    static void close(Pipe& pipe);
+
+    std::vector<Pipe> idle_;
+    size_t max_idle_;
+    int pipe_size_;
+    size_t created_ = 0;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "socket_address.h"
+
+//监听方式：
+//ReusePort - 每个reactor持有自己的SO_REUSEPORT监听套接字，由内核按连接哈希分发
+//Exclusive - 所有reactor共享同一个监听套接字，通过EPOLLEXCLUSIVE避免惊群
+enum class ListenMode {
+    ReusePort,
+    Exclusive
+};
+
+//应用层协议：Raw - 按收到的字节流原样回显；LengthPrefixed/Line - 分帧后逐条回显完整消息；Http - HTTP/1.1
+enum class Protocol {
+    Raw,
+    LengthPrefixed,
+    Line,
+    Http
+};
+
+//事件后端：Epoll - 就绪通知；IoUring - 完成通知
+enum class Backend {
+    Epoll,
+    IoUring
+};
+
+//反向代理选择后端的方式：RoundRobin - 轮询；LeastConnections - 当前连接数最少
+enum class Balance {
+    RoundRobin,
+    LeastConnections
+};
+
+//慢订阅者（发送队列超过上限）的处理：Drop - 丢弃发给它的新消息；Disconnect - 断开连接
+enum class SlowSubscriber {
+    Drop,
+    Disconnect
+};
+
+//服务器的运行时配置：命令行与配置文件使用同一组键名，命令行覆盖配置文件
+//数值为0的套接字选项表示保持内核默认值
+struct ServerConfig {
+    int threads = 0;                //0表示按CPU数
+    std::vector<SocketAddress> listen{SocketAddress::any(8080)};   //全部地址表示IPv6双栈
+    int backlog = 128;
+    int events_per_wait = 1024;     //每次epoll_wait最多取回的事件数
+    ListenMode listen_mode = ListenMode::ReusePort;
+    Backend backend = Backend::Epoll;
+    Protocol protocol = Protocol::Raw;
+    bool async_log = true;
+    uint32_t info_sampling = 1;
+    std::string handler = "echo";
+    std::string session;            //非空时业务连接改由协程会话处理，protocol与handler不再生效
+    size_t worker_threads = 0;
+    int metrics_port = 9100;        //0表示不提供指标页面
+    size_t max_connections = 0;     //全部reactor的连接总数上限，0表示按RLIMIT_NOFILE推算
+
+    //非空时作为四层代理：每个业务连接转发到其中一个后端，protocol、handler与session不再生效
+    std::vector<SocketAddress> upstreams;
+    Balance balance = Balance::RoundRobin;
+    size_t upstream_pool = 2;       //每个reactor为每个后端预先发起的空闲连接数
+    uint64_t connect_timeout_ms = 3000;
+
+    //分帧协议下把SUB/UNSUB/PUB消息当作发布订阅命令，其余消息照常交给handler
+    bool pubsub = false;
+    size_t subscriber_queue = 1024 * 1024;  //订阅者的发送队列超过这个字节数即为慢订阅者
+    SlowSubscriber slow_subscriber = SlowSubscriber::Drop;
+
+    //分帧协议下把GET/SET/DEL/TTL消息当作缓存命令，由按键分片到各reactor的内存键值存储执行
+    bool cache = false;
+    size_t cache_memory = 64 * 1024 * 1024;     //全部分片合计的内存上限，平均分给各reactor
+
+    //监听套接字上的选项，接受的连接从监听套接字继承
+    int send_buffer = 0;
+    int receive_buffer = 0;
+    bool tcp_nodelay = false;
+    int defer_accept = 0;           //秒
+    int fastopen = 0;               //TFO队列长度
+    int busy_poll = 0;              //微秒
+
+    //reactor线程绑定的CPU，第i个reactor绑定cpus[i % size]；为空时不绑定
+    std::vector<int> cpus;
+};
+
+//设置一个键，value不合法或键未知时打印原因并返回false
+bool setConfigOption(ServerConfig& config, const std::string& key, const std::string& value);
+
+//配置文件每行一个"键 = 值"，#之后为注释
+bool loadConfigFile(const std::string& path, ServerConfig& config);
+
+//命令行：--键 值 或 --键=值；--config 文件 先于其余选项生效
+//第一个参数不以-开头时按旧的位置参数解析：线程数 监听方式 后端 协议 日志模式 info采样 处理器 工作线程数 指标端口
+//返回false表示应退出（参数错误或--help）
+bool parseCommandLine(int argc, char* argv[], ServerConfig& config);
+
+void printUsage(std::ostream& out, const char* program);
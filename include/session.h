@@ -0,0 +1,140 @@
+#pragma once
+
+#include "coroutine.h"
+#include "timer_wheel.h"
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <sys/types.h>
+
+class RingBuffer;
+
+//协程会话看到的连接：由事件循环实现，会话只通过read/write/sleep三个可等待对象与循环交互
+//能立即完成的操作不挂起；同一时刻最多一个协程挂起在一条连接上
+//连接被关闭（对端断开、超时、服务器停止）时挂起的协程立即以失败恢复，之后的操作都不再挂起
+class CoStream {
+public:
+    virtual ~CoStream() = default;
+
+    class ReadAwaiter {
+    public:
+        explicit ReadAwaiter(CoStream& stream) : stream_(stream), result_(-1) {}
+        bool await_ready() { result_ = stream_.readSome(); return result_ >= 0; }
+        void await_suspend(std::coroutine_handle<> h) { stream_.suspend(Wait::Read, h); }
+        size_t await_resume() { return static_cast<size_t>(result_ >= 0 ? result_ : stream_.result_); }
+
+    private:
+        CoStream& stream_;
+        ssize_t result_;
+    };
+
+    class WriteAwaiter {
+    public:
+        WriteAwaiter(CoStream& stream, std::string_view data) : stream_(stream), data_(data), suspended_(false) {}
+        bool await_ready() {
+            bool backlogged = false;
+            ok_ = stream_.writeSome(data_, backlogged);
+            return !ok_ || !backlogged;
+        }
+        void await_suspend(std::coroutine_handle<> h) { suspended_ = true; stream_.suspend(Wait::Write, h); }
+        bool await_resume() const { return suspended_ ? stream_.result_ > 0 : ok_; }
+
+    private:
+        CoStream& stream_;
+        std::string_view data_;
+        bool ok_ = false;
+        bool suspended_;
+    };
+
+    //定时器节点就在等待者对象里，随协程帧存放，不另外分配
+    class SleepAwaiter {
+    public:
+        SleepAwaiter(CoStream& stream, uint64_t ms) : stream_(stream), ms_(ms) {}
+        bool await_ready() const { return ms_ == 0 || !stream_.isOpen(); }
+        void await_suspend(std::coroutine_handle<> h);
+        bool await_resume() const { return stream_.isOpen(); }
+
+    private:
+        CoStream& stream_;
+        uint64_t ms_;
+        TimerNode timer_;
+    };
+
+    //等待新数据追加到input()，返回本次读入的字节数；0表示对端关闭、出错或输入缓冲已满
+    ReadAwaiter read() { return ReadAwaiter(*this); }
+    //data追加到发送队列并尽量立即写出，data在返回前就已拷贝，不必保持有效
+    //发送队列超过高水位时挂起到降回低水位；返回false表示连接已断开
+    WriteAwaiter write(std::string_view data) { return WriteAwaiter(*this, data); }
+    //在本连接所属循环的时间轮上等待ms毫秒；连接在此期间关闭时提前返回false
+    SleepAwaiter sleep(uint64_t ms) { return SleepAwaiter(*this, ms); }
+
+    virtual RingBuffer& input() = 0;
+    virtual bool isOpen() const = 0;
+    virtual const std::string& peerName() const = 0;
+
+protected:
+    enum class Wait {
+        None,
+        Read,
+        Write,
+        Sleep
+    };
+
+    //从套接字读入input()：>0为字节数，0为关闭/出错/缓冲已满，-1为暂无数据
+    virtual ssize_t readSome() = 0;
+    //返回false表示连接已断开；backlogged为true表示发送队列超过高水位
+    virtual bool writeSome(std::string_view data, bool& backlogged) = 0;
+    virtual void scheduleTimer(TimerNode& timer, uint64_t ms) = 0;
+    virtual void cancelTimer(TimerNode& timer) = 0;
+
+    Wait waiting() const { return waiting_; }
+    //事件循环在等待的条件满足时调用，result交给等待者：读为字节数，写和睡眠为1/0
+    void wake(Wait kind, ssize_t result);
+    //连接关闭时调用：取消睡眠定时器，以失败恢复挂起的协程
+    void abortWaiter();
+
+private:
+    void suspend(Wait kind, std::coroutine_handle<> h) {
+        waiting_ = kind;
+        waiter_ = h;
+    }
+
+    std::coroutine_handle<> waiter_;
+    Wait waiting_ = Wait::None;
+    ssize_t result_ = 0;
+    TimerNode* sleep_timer_ = nullptr;
+};
+
+//按连接编写的协议逻辑：每个连接启动一个serve协程，协程返回后服务器写完发送队列并关闭连接
+//serve在reactor线程上运行，帧从该reactor的FramePool分配；实现本身须无状态，状态放在协程的局部变量中
+class SessionHandler {
+public:
+    virtual ~SessionHandler() = default;
+    virtual Task<> serve(CoStream& stream) const = 0;
+    virtual const char* name() const = 0;
+};
+
+//原样回显字节流
+class EchoSession : public SessionHandler {
+public:
+    Task<> serve(CoStream& stream) const override;
+    const char* name() const override { return "echo"; }
+};
+
+//按行处理："毫秒数 文本"等待指定时间后回复文本，演示在协议中穿插定时等待；不合法的行回复"ERR"
+class DelaySession : public SessionHandler {
+public:
+    Task<> serve(CoStream& stream) const override;
+    const char* name() const override { return "delay"; }
+
+    static constexpr uint64_t MAX_DELAY_MS = 10000;
+    static constexpr size_t MAX_LINE = 4096;
+};
+
+//按名称创建会话处理器，未知名称返回nullptr
+std::unique_ptr<SessionHandler> createSession(const std::string& name);
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+//不可变的引用计数缓冲区：计数、长度与数据在同一次分配中
+//广播时一条消息只分配一次，每个订阅者的发送队列只持有一个引用；计数是原子的，可以跨reactor传递
+//allocate之后、第一次复制之前由创建者通过mutableData填写内容，之后只读
+class SharedBuffer {
+public:
+    SharedBuffer() = default;
+    ~SharedBuffer() { release(); }
+
+    SharedBuffer(const SharedBuffer& other) : block_(other.block_) { retain(); }
+    SharedBuffer(SharedBuffer&& other) noexcept : block_(std::exchange(other.block_, nullptr)) {}
+
+    SharedBuffer& operator=(const SharedBuffer& other) {
+        if (block_ != other.block_) {
+            release();
+            block_ = other.block_;
+            retain();
+        }
+        return *this;
+    }
+    SharedBuffer& operator=(SharedBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            block_ = std::exchange(other.block_, nullptr);
+        }
+        return *this;
+    }
+
+    static SharedBuffer allocate(size_t size);
+    static SharedBuffer copyOf(std::string_view bytes);
+
+    explicit operator bool() const { return block_ != nullptr; }
+    const char* data() const { return block_ != nullptr ? reinterpret_cast<const char*>(block_ + 1) : nullptr; }
+    char* mutableData() { return block_ != nullptr ? reinterpret_cast<char*>(block_ + 1) : nullptr; }
+    size_t size() const { return block_ != nullptr ? block_->size : 0; }
+    std::string_view view() const { return std::string_view(data(), size()); }
+    uint32_t useCount() const { return block_ != nullptr ? block_->refs.load(std::memory_order_relaxed) : 0; }
+
+private:
+    //保持16字节，数据紧随其后仍按默认对齐
+    struct alignas(16) Block {
+        std::atomic<uint32_t> refs;
+        size_t size;
+    };
+
+    void retain() {
+        if (block_ != nullptr) {
+            block_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    void release() {
+        if (block_ != nullptr && block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            destroy(block_);
+        }
+        block_ = nullptr;
+    }
+    static void destroy(Block* block);
+
+    Block* block_ = nullptr;
+};
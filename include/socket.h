@@ -2,10 +2,26 @@
 
 #include <string>
 #include <vector>
+#include <span>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+
+class RingBuffer;
+class DatagramBatch;
+class SocketAddress;
+
+//Stream - TCP流式套接字；Datagram - UDP数据报套接字
+enum class SocketType {
+    Stream,
+    Datagram
+};
 
 class Socket {
 public:
     Socket();
+    explicit Socket(int fd);
     ~Socket();
 
     Socket(const Socket&) = delete;
@@ -14,26 +30,88 @@ public:
     Socket(Socket&& other) noexcept;
     Socket& operator=(Socket&& other) noexcept;
 
-    bool createSocket();
+    //family为AF_INET/AF_INET6/AF_UNIX，只有IP套接字设置SO_REUSEADDR
+    bool createSocket(SocketType type = SocketType::Stream, int family = AF_INET);
     bool bindSocket(int port);
+    //绑定到指定的IPv4/IPv6地址，host为空或"*"时绑定全部地址
+    bool bindSocket(const std::string& host, int port);
+    //地址族须与createSocket时一致；IPv6通配地址关闭IPV6_V6ONLY，同时接受IPv4连接
+    bool bindSocket(const SocketAddress& address);
     bool listenSocket(int backlog);
     Socket acceptSocket();
+    //accept4(SOCK_NONBLOCK|SOCK_CLOEXEC)：新连接已是非阻塞的，对端地址随accept一并取回，省去fcntl和getpeername
+    //失败时返回无效Socket并保留errno（EAGAIN表示暂无新连接，EMFILE/ENFILE等交由调用方处理），不打印错误
+    Socket acceptNonBlocking(SocketAddress& peer);
+    //ip可以是IPv4/IPv6字面量或主机名；地址族与创建时不同且尚未连接时，按目标地址族重新创建套接字
     bool connect(const std::string& ip, int port);
+    bool connect(const SocketAddress& address);
+    //非阻塞connect：按目标地址族新建非阻塞套接字（已有的fd先关闭）并发起连接，立即返回
+    //返回true表示已连接或正在连接，等到可写后用finishConnect确认结果；失败时保留errno，不打印错误
+    bool connectNonBlocking(const SocketAddress& address);
+    //带超时的connect：以非阻塞方式发起，poll等待握手完成，超时errno为ETIMEDOUT；成功后套接字恢复为阻塞模式
+    bool connect(const SocketAddress& address, int timeout_ms);
+    //可写通知到达后调用：0表示已连接，EINPROGRESS表示仍在握手，其余为连接失败的errno（取出后清除）
+    int finishConnect();
+    //shutdown(SHUT_WR)：发出FIN，仍可继续读取对端的数据
+    bool shutdownWrite();
 
     ssize_t send(const std::vector<char>& data);
     ssize_t send(const std::string& data);
     ssize_t recv(std::vector<char>& buffer, size_t size);
 
+    //分散/聚集IO：一次系统调用收发多段不连续的内存，段数超过IOV_MAX时只处理前IOV_MAX段
+    ssize_t sendv(std::span<const struct iovec> iov);
+    ssize_t recvv(std::span<const struct iovec> iov);
+
+    //发送/接收了n字节后跳过已完成的段，并调整首个未完成段的起点，返回剩余段
+    static std::span<struct iovec> advance(std::span<struct iovec> iov, size_t n);
+
+    //零拷贝发送，数据不经过用户态：sendFile从普通文件的offset处发送最多count字节并推进offset
+    //spliceFrom从管道搬运最多count字节到套接字；两者都不阻塞在管道上，套接字写满时返回-1且errno为EAGAIN
+    ssize_t sendFile(int file_fd, off_t& offset, size_t count);
+    ssize_t spliceFrom(int pipe_fd, size_t count);
+    //反方向：从套接字搬运最多count字节到管道，对端关闭时返回0；管道写满与套接字无数据同样返回EAGAIN，调用方须自己记录管道余量
+    ssize_t spliceTo(int pipe_fd, size_t count);
+
+    //直接在环形缓冲区上收发：recv读满可写区域，send发送可读区域并消费已发送部分
+    ssize_t recv(RingBuffer& buffer);
+    ssize_t send(RingBuffer& buffer);
+
+    //批量收发数据报（recvmmsg/sendmmsg），返回本次处理的数据报个数，出错返回-1
+    //非阻塞模式下没有数据时返回-1且errno为EAGAIN
+    int recvBatch(DatagramBatch& batch);
+    int sendBatch(DatagramBatch& batch);
+
     bool setNonBlocking(bool nonblock = true);
+    bool setReusePort(bool enable = true);
+    bool setNoDelay(bool enable = true);
+    //SO_SNDBUF/SO_RCVBUF：须在listen之前设置，接受的连接继承监听套接字的设置，接收窗口的缩放因子也在握手时按它确定
+    bool setSendBufferSize(int bytes);
+    bool setReceiveBufferSize(int bytes);
+    //TCP_DEFER_ACCEPT：连接上有数据到达（或超过seconds秒）才让accept返回，省去一次空等的可读通知
+    bool setDeferAccept(int seconds);
+    //TCP_FASTOPEN：允许SYN携带数据，queue_len为尚未完成握手的TFO请求队列长度
+    bool setFastOpen(int queue_len);
+    //SO_BUSY_POLL：阻塞读取时先在驱动队列上忙等最多usec微秒，以CPU换延迟；需要内核允许
+    bool setBusyPoll(int usec);
+    //SO_INCOMING_CPU：SO_REUSEPORT组中优先把在该CPU上收到的连接交给这个套接字
+    bool setIncomingCpu(int cpu);
 
     void close();
 
     int getFd() const{ return fd_; }
     bool isValid() const { return fd_ != -1; }
+    SocketType getType() const { return type_; }
+    //接管的fd（Socket(int)）地址族未知，为AF_UNSPEC
+    int getFamily() const { return family_; }
+    //IP地址或Unix路径；Unix套接字没有端口，getPeerPort返回0
     std::string getPeerAddress() const;
     int getPeerPort() const;
+    bool getPeerName(SocketAddress& peer) const;
 
 private:
     int fd_;
     bool is_non_blocking_;
+    SocketType type_;
+    int family_;
 };
\ No newline at end of file
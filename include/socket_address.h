@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include <sys/socket.h>
+
+//与地址族无关的套接字地址：IPv4、IPv6或AF_UNIX，按值保存在sockaddr_storage中，可直接交给bind/connect/accept
+//文本形式：
+//  "1.2.3.4:80"、"[::1]:80"、"host:80"（按需getaddrinfo，只在解析时查询一次）
+//  "80"或"*:80" - 全部地址，IPv6双栈，同时接受IPv4连接
+//  "unix:/path"或"/path" - Unix域套接字；"unix:@name" - 抽象命名空间
+class SocketAddress {
+public:
+    SocketAddress();
+
+    //[::]:port，绑定时关闭IPV6_V6ONLY
+    static SocketAddress any(int port);
+    static SocketAddress ipv4Any(int port);
+
+    static bool parse(std::string_view text, SocketAddress& out);
+    //host可以是IPv4/IPv6字面量或主机名，为空或"*"时等同于any；为Unix地址时忽略port
+    static bool resolve(const std::string& host, int port, SocketAddress& out);
+
+    bool isValid() const { return length_ != 0; }
+    int family() const { return storage_.ss_family; }
+    bool isInet() const { return family() == AF_INET || family() == AF_INET6; }
+    bool isUnix() const { return family() == AF_UNIX; }
+    bool isWildcard() const;
+
+    //供bind/connect读取，供accept/getpeername/recvfrom写入（写入前把length设为capacity）
+    const struct sockaddr* get() const { return reinterpret_cast<const struct sockaddr*>(&storage_); }
+    struct sockaddr* get() { return reinterpret_cast<struct sockaddr*>(&storage_); }
+    socklen_t length() const { return length_; }
+    socklen_t& length() { return length_; }
+    static constexpr socklen_t capacity() { return sizeof(struct sockaddr_storage); }
+    const struct sockaddr_storage& storage() const { return storage_; }
+
+    //IP地址或Unix路径（抽象命名空间以@开头，未命名的对端为空串）；Unix地址的端口为0
+    std::string host() const;
+    int port() const;
+    //"1.2.3.4:80"、"[::1]:80"、"unix:/path"
+    std::string toString() const;
+
+    //Unix域套接字的路径，抽象命名空间和未命名地址返回空串
+    std::string unixPath() const;
+
+private:
+    struct sockaddr_storage storage_;
+    socklen_t length_;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "epoll.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+//跨线程投递给事件循环的任务队列：多生产者单消费者，无锁（Vyukov侵入式链表）
+//投递后通过eventfd唤醒循环；在循环处理之前的多次投递只写一次eventfd
+//epoll后端把fd以EPOLLIN注册，handleEvent中读掉计数并执行全部任务；
+//其他后端（如io_uring）自行读取eventfd后调用runPending
+class TaskQueue : public EpollHandler {
+public:
+    using Task = std::function<void()>;
+
+    TaskQueue();
+    ~TaskQueue() override;
+
+    TaskQueue(const TaskQueue&) = delete;
+    TaskQueue& operator=(const TaskQueue&) = delete;
+
+    bool open();
+    void close();
+    int getFd() const { return event_fd_; }
+
+    //任意线程调用；eventfd尚未打开或已关闭时返回false，任务不会执行
+    bool post(Task task);
+
+    //只由循环线程调用：执行当前已投递的全部任务，返回执行的个数
+    size_t runPending();
+    //累计执行的任务数，只在循环线程上读
+    uint64_t executed() const { return executed_; }
+
+    void handleEvent(uint32_t events) override;
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        Task task;
+    };
+
+    void push(Node* node);
+    Node* pop();
+
+    std::atomic<int> event_fd_;
+    std::atomic<bool> signaled_;    //已写eventfd且循环还没开始处理
+    std::atomic<Node*> head_;       //生产者一端
+    Node* tail_;                    //消费者一端
+    uint64_t executed_;
+    Node stub_;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//工作窃取线程池：每个工作线程一个任务队列，自己从队首取，空闲时从其他队列的队尾偷
+//外部线程（如reactor）提交时轮流放入各队列；工作线程内部提交时放入自己的队列
+//每个队列一把锁，只在同一队列的提交、取出与窃取之间竞争，不存在全局锁
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(size_t thread_count);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    bool start();
+    //丢弃尚未开始的任务，等待正在执行的任务结束
+    void stop();
+
+    void submit(Task task);
+    size_t size() const { return queues_.size(); }
+    //尚未开始执行的任务数（近似值）
+    size_t pending() const;
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool popLocal(size_t index, Task& task);
+    bool steal(size_t thief, Task& task);
+    void workerLoop(size_t index);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> next_queue_;
+    std::atomic<size_t> pending_;       //全部队列中的任务数
+    std::atomic<size_t> sleepers_;      //正在等待的工作线程数，为0时提交方无需唤醒
+    std::atomic<bool> running_;
+    std::atomic<uint32_t> wake_seq_;    //空闲的工作线程在它上面atomic wait（futex），提交时递增并notify
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+class TimerWheel;
+
+//侵入式定时器节点：嵌入在连接等对象中，调度、重新调度与取消都是O(1)且不分配内存
+//回调在构造或setCallback时设置一次，之后反复调度只需改动链表指针
+class TimerNode {
+public:
+    using Callback = std::function<void()>;
+
+    TimerNode() = default;
+    explicit TimerNode(Callback callback) : callback_(std::move(callback)) {}
+    ~TimerNode();
+
+    TimerNode(const TimerNode&) = delete;
+    TimerNode& operator=(const TimerNode&) = delete;
+
+    void setCallback(Callback callback) { callback_ = std::move(callback); }
+    bool isScheduled() const { return wheel_ != nullptr; }
+
+private:
+    friend class TimerWheel;
+
+    TimerNode* prev_ = nullptr;
+    TimerNode* next_ = nullptr;
+    TimerWheel* wheel_ = nullptr;
+    uint64_t expire_ = 0;       //到期的tick
+    uint8_t level_ = 0;         //所在层与槽位，取消时据此找到链表头
+    uint8_t slot_ = 0;
+    Callback callback_;
+};
+
+//分层时间轮：4层，每层64个槽，第0层每槽一个tick，上层每槽覆盖下层一整圈
+//定时器先放在与到期时间相称的层上，随时间推进逐层下放，到达第0层后按槽触发
+//每层用一个64位位图记录非空槽，计算下一次到期时间不需要扫描链表
+class TimerWheel {
+public:
+    explicit TimerWheel(uint64_t tick_ms = 10, uint64_t now_ms = nowMs());
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    //delay_ms后触发；节点已在调度中时直接移动到新位置
+    void schedule(TimerNode& node, uint64_t delay_ms);
+    void cancel(TimerNode& node);
+
+    //推进到now_ms并依次执行到期的回调，回调中可以调度或取消任意定时器
+    void advance(uint64_t now_ms);
+
+    //距下一次可能到期的毫秒数，用作epoll_wait的超时；没有定时器时返回-1
+    int nextTimeout(uint64_t now_ms) const;
+
+    size_t size() const { return size_; }
+    uint64_t tickMs() const { return tick_ms_; }
+
+    //单调时钟，毫秒
+    static uint64_t nowMs();
+
+private:
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const uint64_t SLOT_MASK = SLOTS - 1;
+
+    void link(TimerNode& node);
+    void unlink(TimerNode& node);
+    void cascade(int level, int slot);
+
+    TimerNode* slots_[LEVELS][SLOTS];
+    uint64_t occupied_[LEVELS];     //非空槽位图
+    uint64_t tick_ms_;
+    uint64_t start_ms_;
+    uint64_t current_;              //当前tick，槽位current_ & SLOT_MASK已处理完
+    size_t size_;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+//主题 -> 订阅者列表，每个reactor一份，只登记本reactor上的连接，不加锁
+//T需要提供 std::vector<std::string>& topics()：记录该订阅者订阅的主题，断开时据此逐个退订
+//列表中删除一项时用末尾元素填补空位：倒序遍历列表时删除当前元素是安全的，投递过程中可以断开慢订阅者
+template <typename T>
+class TopicRegistry {
+public:
+    //查找时可以直接用string_view，不构造临时的std::string
+    struct Hash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>()(s); }
+    };
+
+    using Subscribers = std::vector<T*>;
+
+    //已订阅时返回false
+    bool subscribe(std::string_view topic, T* subscriber) {
+        std::vector<std::string>& topics = subscriber->topics();
+        if (std::find(topics.begin(), topics.end(), topic) != topics.end()) {
+            return false;
+        }
+        auto it = topics_.find(topic);
+        if (it == topics_.end()) {
+            it = topics_.emplace(std::string(topic), Subscribers()).first;
+        }
+        it->second.push_back(subscriber);
+        topics.emplace_back(topic);
+        subscriptions_++;
+        return true;
+    }
+
+    //未订阅时返回false
+    bool unsubscribe(std::string_view topic, T* subscriber) {
+        std::vector<std::string>& topics = subscriber->topics();
+        auto own = std::find(topics.begin(), topics.end(), topic);
+        if (own == topics.end()) {
+            return false;
+        }
+        remove(topic, subscriber);
+        *own = std::move(topics.back());
+        topics.pop_back();
+        return true;
+    }
+
+    void unsubscribeAll(T* subscriber) {
+        std::vector<std::string>& topics = subscriber->topics();
+        for (const std::string& topic : topics) {
+            remove(topic, subscriber);
+        }
+        topics.clear();
+    }
+
+    //没有订阅者时返回nullptr；最后一个订阅者退订时主题被删除，返回的指针随之失效
+    const Subscribers* find(std::string_view topic) const {
+        auto it = topics_.find(topic);
+        return it == topics_.end() ? nullptr : &it->second;
+    }
+
+    size_t topics() const { return topics_.size(); }
+    size_t subscriptions() const { return subscriptions_; }
+
+private:
+    void remove(std::string_view topic, T* subscriber) {
+        auto it = topics_.find(topic);
+        if (it == topics_.end()) {
+            return;
+        }
+        Subscribers& subs = it->second;
+        auto pos = std::find(subs.begin(), subs.end(), subscriber);
+        if (pos != subs.end()) {
+            *pos = subs.back();
+            subs.pop_back();
+            subscriptions_--;
+        }
+        if (subs.empty()) {
+            topics_.erase(it);
+        }
+    }
+
+    std::unordered_map<std::string, Subscribers, Hash, std::equal_to<>> topics_;
+    size_t subscriptions_ = 0;
+};
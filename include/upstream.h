@@ -0,0 +1,67 @@
+#pragma once
+
+#include "server_config.h"
+#include "socket.h"
+#include "socket_address.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+//一个reactor眼中的后端集合：按策略选择后端、记录连接数与失败冷却，并为每个后端保留几条预先发起的连接
+//每个reactor持有自己的一份，只由所属线程访问；最少连接数因此按本reactor的连接计算，不跨线程同步
+class UpstreamGroup {
+public:
+    UpstreamGroup(const std::vector<SocketAddress>& backends, Balance balance, size_t pool_size);
+
+    UpstreamGroup(const UpstreamGroup&) = delete;
+    UpstreamGroup& operator=(const UpstreamGroup&) = delete;
+
+    size_t size() const { return backends_.size(); }
+    const SocketAddress& address(size_t index) const { return backends_[index].address; }
+    size_t activeConnections(size_t index) const { return backends_[index].active; }
+
+    //按策略选一个后端，跳过仍在失败冷却期的；全部在冷却期时忽略冷却
+    size_t pick(uint64_t now_ms);
+
+    //取一条到index的非阻塞连接：优先用预连接池中仍然可用的，否则新发起；pooled表示是否来自池
+    //返回的连接可能仍在握手，调用方等可写后用finishConnect确认；失败返回无效Socket并保留errno
+    Socket connect(size_t index, uint64_t now_ms, bool& pooled);
+
+    //把每个不在冷却期的后端的预连接池补满
+    void refill(uint64_t now_ms);
+
+    //连接建立/结束时调用，最少连接数据此选择
+    void onOpen(size_t index) { backends_[index].active++; }
+    void onClose(size_t index);
+    //连接失败：后端进入冷却期，期间pick不再选它，预连接池清空
+    void onFailure(size_t index, uint64_t now_ms);
+
+    static constexpr uint64_t FAILURE_COOLDOWN_MS = 2000;
+    //预连接在池中放得太久可能已被后端的空闲超时关闭，超过这个时间直接丢弃
+    static constexpr uint64_t POOL_MAX_IDLE_MS = 10000;
+
+private:
+    struct Pooled {
+        Socket socket;
+        uint64_t created_ms;
+    };
+
+    struct Backend {
+        SocketAddress address;
+        size_t active = 0;
+        uint64_t down_until_ms = 0;
+        std::deque<Pooled> pool;
+    };
+
+    bool isDown(const Backend& backend, uint64_t now_ms) const { return backend.down_until_ms > now_ms; }
+    void refill(Backend& backend, uint64_t now_ms);
+    //池中的连接仍在握手或已连上且对端没有关闭
+    static bool isUsable(Socket& socket);
+
+    std::vector<Backend> backends_;     //构造时定长，Backend不可拷贝
+    Balance balance_;
+    size_t pool_size_;
+    size_t next_ = 0;       //轮询的下一个位置
+};
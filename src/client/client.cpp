@@ -3,22 +3,36 @@
 #include <vector>
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <cstdlib>
 
 #include "../../include/socket.h"
+#include "../../include/buffer.h"
+#include "../../include/codec.h"
+#include "../../include/load_generator.h"
+#include "../../include/client_pool.h"
+#include "../../include/socket_address.h"
 #include "spdlog/spdlog.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include "spdlog/sinks/basic_file_sink.h"
 
 class EchoClient {
 private:
+    static const size_t BUFFER_SIZE = 16384;
+    static const int CONNECT_TIMEOUT_MS = 3000;
+
     Socket socket_;
+    BufferPool pool_;
+    RingBuffer input_;          //跨多次recv累积，直到凑出一整行回显
+    DelimiterCodec codec_;
     std::string server_ip_;
     int server_port_;
     bool connected_;
     std::shared_ptr<spdlog::logger> logger_;
 
 public:
-    EchoClient(const std::string &server_ip, int server_port): server_ip_(server_ip), server_port_(server_port), connected_(false) {
+    EchoClient(const std::string &server_ip, int server_port)
+        : pool_(BUFFER_SIZE, 1), input_(&pool_), codec_(BUFFER_SIZE - 1), server_ip_(server_ip), server_port_(server_port), connected_(false) {
         auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
         auto file_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>("logs/server.log", true);
 
@@ -32,13 +46,15 @@ public:
         disconnect();
     }
 
+    //服务器不可达时最多等CONNECT_TIMEOUT_MS，而不是内核的SYN重传超时（约两分钟）
     bool connect() {
-        if (!socket_.createSocket()) {
-            logger_->error("Failed to create socket");
+        SocketAddress address;
+        if (!SocketAddress::resolve(server_ip_, server_port_, address)) {
+            logger_->error("Failed to resolve {}", server_ip_);
             return false;
         }
 
-        if (!socket_.connect(server_ip_, server_port_)) {
+        if (!socket_.connect(address, CONNECT_TIMEOUT_MS)) {
             logger_->error("Failed to connect to server");
             return false;
         }
@@ -72,25 +88,34 @@ public:
         return true;
     }
 
+    //回显以换行结尾，一次recv不一定能拿到完整的一行，按分隔符分帧后再输出
     bool receiveResponse() {
         if (!connected_) {
             logger_->error("Failed to receive message: connection lost");
             return false;
         }
 
-        std::vector<char> buffer;
-        ssize_t bytes_received = socket_.recv(buffer, 4096);
+        Frame frame;
+        while (true) {
+            FrameCodec::DecodeResult result = codec_.decode(input_, frame);
+            if (result == FrameCodec::DecodeResult::Frame) {
+                logger_->info("Received: {} ({} bytes)", frame.payload, frame.wire_size);
+                input_.consume(frame.wire_size);
+                return true;
+            }
+            if (result == FrameCodec::DecodeResult::Error) {
+                logger_->error("Response too long");
+                return false;
+            }
 
-        if (bytes_received > 0) {
-            std::string response(buffer.begin(), buffer.end());
-            logger_->info("Received: {} ({} bytes)", response, bytes_received);
-            return true;
-        } else if (bytes_received == 0) {
-            logger_->error("Connection closed");
-            return false;
-        } else {
-            logger_->error("Failed to connect to server");
-            return false;
+            ssize_t bytes_received = socket_.recv(input_);
+            if (bytes_received == 0) {
+                logger_->error("Connection closed");
+                return false;
+            } else if (bytes_received < 0) {
+                logger_->error("Failed to connect to server");
+                return false;
+            }
         }
     }
 
@@ -125,7 +150,136 @@ public:
     }
 };
 
+//压测模式：client --bench [--host H] [--port P] [--connections N] [--threads T] [--size B]
+//                  [--pipeline D] [--rate R] [--duration S] [--warmup S] [--protocol raw|line|length]
+static int runBenchmark(int argc, char* argv[]) {
+    LoadGeneratorOptions options;
+    for (int i = 2; i < argc; i++) {
+        std::string key = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << key << std::endl;
+            return -1;
+        }
+        std::string value = argv[++i];
+        if (key == "--host") {
+            options.host = value;
+        } else if (key == "--port") {
+            options.port = std::atoi(value.c_str());
+        } else if (key == "--connections") {
+            options.connections = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--threads") {
+            options.threads = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--size") {
+            options.message_size = static_cast<size_t>(std::max(1, std::atoi(value.c_str())));
+        } else if (key == "--pipeline") {
+            options.pipeline = std::max(1, std::atoi(value.c_str()));
+        } else if (key == "--rate") {
+            options.rate = std::atof(value.c_str());
+        } else if (key == "--duration") {
+            options.duration = std::atof(value.c_str());
+        } else if (key == "--warmup") {
+            options.warmup = std::atof(value.c_str());
+        } else if (key == "--protocol") {
+            if (value == "line") {
+                options.framing = LoadGeneratorOptions::Framing::Line;
+            } else if (value == "length") {
+                options.framing = LoadGeneratorOptions::Framing::LengthPrefixed;
+            } else {
+                options.framing = LoadGeneratorOptions::Framing::Raw;
+            }
+        } else {
+            std::cerr << "Unknown option " << key << std::endl;
+            return -1;
+        }
+    }
+    options.threads = std::min(options.threads, options.connections);
+
+    std::cout << "Benchmarking " << options.host << ":" << options.port << " ..." << std::endl;
+    LoadGenerator generator(options);
+    LoadGeneratorResult result;
+    bool ok = generator.run(result);
+    LoadGenerator::printReport(options, result);
+    return ok ? 0 : -1;
+}
+
+//连接池模式：client --pool [--host H] [--port P] [--connections N] [--pipeline D] [--requests R]
+//                 [--size B] [--protocol line|length]
+//在N条预热的连接上流水线发出R条请求，逐条核对回显，输出耗时与吞吐
+static int runPool(int argc, char* argv[]) {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    ClientPool::Options options;
+    size_t requests = 10000;
+    size_t size = 64;
+    for (int i = 2; i < argc; i++) {
+        std::string key = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << key << std::endl;
+            return -1;
+        }
+        std::string value = argv[++i];
+        if (key == "--host") {
+            host = value;
+        } else if (key == "--port") {
+            port = std::atoi(value.c_str());
+        } else if (key == "--connections") {
+            options.connections = static_cast<size_t>(std::max(1, std::atoi(value.c_str())));
+        } else if (key == "--pipeline") {
+            options.pipeline = static_cast<size_t>(std::max(1, std::atoi(value.c_str())));
+        } else if (key == "--requests") {
+            requests = static_cast<size_t>(std::max(1, std::atoi(value.c_str())));
+        } else if (key == "--size") {
+            size = static_cast<size_t>(std::max(1, std::atoi(value.c_str())));
+        } else if (key == "--protocol") {
+            options.framing = value == "length" ? ClientPool::Framing::LengthPrefixed : ClientPool::Framing::Line;
+        } else {
+            std::cerr << "Unknown option " << key << std::endl;
+            return -1;
+        }
+    }
+
+    SocketAddress target;
+    if (!SocketAddress::resolve(host, port, target)) {
+        std::cerr << "Failed to resolve " << host << std::endl;
+        return -1;
+    }
+    ClientPool pool(target, options);
+    if (!pool.start()) {
+        return -1;
+    }
+
+    std::string request(size, 'x');
+    size_t ok = 0;
+    size_t failed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < requests; i++) {
+        request[0] = static_cast<char>('a' + i % 26);
+        char expected = request[0];
+        pool.submit(request, [&ok, &failed, expected, size](bool success, std::string_view response) {
+            if (success && response.size() == size && response[0] == expected) {
+                ok++;
+            } else {
+                failed++;
+            }
+        });
+    }
+    bool drained = pool.drain(30 * 1000);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "requests: " << requests << ", ok: " << ok << ", failed: " << failed
+              << ", connections: " << options.connections << ", pipeline: " << options.pipeline << std::endl;
+    std::cout << "elapsed: " << elapsed << " s, " << static_cast<double>(ok) / elapsed << " req/s" << std::endl;
+    return drained && failed == 0 ? 0 : -1;
+}
+
 int main(int argc, char* argv[]) {
+    if (argc >= 2 && std::string(argv[1]) == "--bench") {
+        return runBenchmark(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "--pool") {
+        return runPool(argc, argv);
+    }
+
     std::string server_ip = "127.0.0.1";
     int server_port = 8080;
 
@@ -147,7 +301,7 @@ int main(int argc, char* argv[]) {
     }
 
     std::cout << "\nTesting connection..." << std::endl;
-    if (client.sendMessage("Hello World!")) {
+    if (client.sendMessage("Hello World!\n")) {
         client.receiveResponse();
     }
     client.interactiveMode();
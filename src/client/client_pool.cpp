@@ -0,0 +1,335 @@
+#include "../../include/client_pool.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+uint64_t nowMs() {
+    using namespace std::chrono;
+    return static_cast<uint64_t>(duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+}
+
+ClientPool::ClientPool(const SocketAddress& target, const Options& options)
+    : target_(target), options_(options), buffers_(BUFFER_SIZE), events_(64) {
+    size_t max_frame = BUFFER_SIZE - LengthPrefixedCodec::HEADER_SIZE;
+    if (options_.framing == Framing::LengthPrefixed) {
+        codec_ = std::make_unique<LengthPrefixedCodec>(max_frame);
+    } else {
+        codec_ = std::make_unique<DelimiterCodec>(max_frame, '\n');
+    }
+    options_.connections = std::max<size_t>(1, options_.connections);
+    options_.pipeline = std::max<size_t>(1, options_.pipeline);
+}
+
+//析构时未完成的请求不再回调
+ClientPool::~ClientPool() {
+    for (auto& conn : conns_) {
+        conn->output.clear();
+        conn->input.consume(conn->input.readable());
+    }
+}
+
+bool ClientPool::start() {
+    if (!epoll_.create()) {
+        std::cerr << "ClientPool: failed to create epoll" << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < options_.connections; i++) {
+        conns_.push_back(std::make_unique<Connection>(this, &buffers_));
+        connect(*conns_.back());
+    }
+    return true;
+}
+
+void ClientPool::submit(std::string_view request, Callback callback) {
+    if (request.size() > codec_->maxFrame()) {
+        complete(callback, false, std::string_view());
+        return;
+    }
+    //前面还有排队的请求时不能插队
+    if (queue_.empty()) {
+        Connection* conn = pickReady();
+        if (conn != nullptr) {
+            conn->in_flight.push_back(std::move(callback));
+            in_flight_++;
+            send(*conn, request);
+            return;
+        }
+    }
+    queue_.push_back(Queued{std::string(request), std::move(callback)});
+}
+
+int ClientPool::poll(int timeout_ms) {
+    completed_ = 0;
+    checkTimers();
+    int n = epoll_.wait(events_, nextTimeout(timeout_ms));
+    if (n > 0) {
+        Epoll::dispatch(std::span<const struct epoll_event>(events_.data(), static_cast<size_t>(n)));
+    }
+    checkTimers();
+    return completed_;
+}
+
+bool ClientPool::drain(int timeout_ms) {
+    uint64_t deadline = nowMs() + static_cast<uint64_t>(std::max(0, timeout_ms));
+    while (pending() > 0) {
+        uint64_t now = nowMs();
+        if (now >= deadline) {
+            return false;
+        }
+        poll(static_cast<int>(deadline - now));
+    }
+    return true;
+}
+
+size_t ClientPool::pending() const {
+    return queue_.size() + in_flight_;
+}
+
+size_t ClientPool::connected() const {
+    return static_cast<size_t>(std::count_if(conns_.begin(), conns_.end(),
+                                             [](const auto& conn) { return conn->state == State::Ready; }));
+}
+
+//握手期间关注EPOLLOUT，可写即表示握手有了结果
+void ClientPool::connect(Connection& conn) {
+    uint64_t now = nowMs();
+    if (!conn.socket.connectNonBlocking(target_)) {
+        conn.state = State::Closed;
+        conn.deadline_ms = now + static_cast<uint64_t>(options_.reconnect_delay_ms);
+        failQueuedIfUnreachable();
+        return;
+    }
+    if (!epoll_.add(conn.socket.getFd(), EpollEvents::IN | EpollEvents::OUT | EpollEvents::ET, &conn)) {
+        conn.socket.close();
+        conn.state = State::Closed;
+        conn.deadline_ms = now + static_cast<uint64_t>(options_.reconnect_delay_ms);
+        return;
+    }
+    conn.state = State::Connecting;
+    conn.want_write = true;
+    conn.deadline_ms = now + static_cast<uint64_t>(options_.connect_timeout_ms);
+}
+
+void ClientPool::handleEvent(Connection& conn, uint32_t events) {
+    if (conn.state == State::Connecting) {
+        int error = conn.socket.finishConnect();
+        if (error == EINPROGRESS) {
+            return;
+        }
+        if (error != 0) {
+            fail(conn, error);
+            return;
+        }
+        onConnected(conn);
+        return;
+    }
+    if (conn.state != State::Ready) {
+        return;
+    }
+    if (events & EpollEvents::ERR) {
+        fail(conn, conn.socket.finishConnect());
+        return;
+    }
+    if (events & EpollEvents::OUT) {
+        flush(conn);
+    }
+    if (conn.state == State::Ready && (events & (EpollEvents::IN | EpollEvents::HUP))) {
+        readResponses(conn);
+    }
+}
+
+void ClientPool::onConnected(Connection& conn) {
+    conn.state = State::Ready;
+    setWantWrite(conn, false);
+    dispatch();
+}
+
+//逐个解出回复交给队首的回调；回调里可以再submit，此后连接若已失败则停止解析
+void ClientPool::readResponses(Connection& conn) {
+    Frame frame;
+    while (conn.state == State::Ready) {
+        ssize_t n = conn.socket.recv(conn.input);
+        if (n == 0) {
+            fail(conn, ECONNRESET);
+            return;
+        }
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                fail(conn, errno);
+                return;
+            }
+            break;
+        }
+
+        while (conn.state == State::Ready) {
+            FrameCodec::DecodeResult result = codec_->decode(conn.input, frame);
+            if (result == FrameCodec::DecodeResult::NeedMore) {
+                break;
+            }
+            if (result == FrameCodec::DecodeResult::Error || conn.in_flight.empty()) {
+                fail(conn, EPROTO);
+                return;
+            }
+            Callback callback = std::move(conn.in_flight.front());
+            conn.in_flight.pop_front();
+            in_flight_--;
+            complete(callback, true, frame.payload);
+            if (conn.state != State::Ready) {
+                return;
+            }
+            conn.input.consume(frame.wire_size);
+        }
+    }
+    conn.input.releaseIfEmpty();
+    dispatch();
+}
+
+//帧头与负载一次writev发出；发送队列非空时排在其后
+bool ClientPool::send(Connection& conn, std::string_view request) {
+    struct iovec iov[3];
+    int cnt = codec_->encode(request, iov);
+    std::span<struct iovec> pending(iov, static_cast<size_t>(cnt));
+
+    if (conn.output.empty()) {
+        ssize_t n = conn.socket.sendv(pending);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                fail(conn, errno);
+                return false;
+            }
+            n = 0;
+        }
+        pending = Socket::advance(pending, static_cast<size_t>(n));
+    }
+    for (const auto& seg : pending) {
+        conn.output.append(static_cast<const char*>(seg.iov_base), seg.iov_len);
+    }
+    if (!conn.output.empty()) {
+        setWantWrite(conn, true);
+    }
+    return true;
+}
+
+void ClientPool::flush(Connection& conn) {
+    if (conn.output.flush(conn.socket) < 0) {
+        fail(conn, errno);
+        return;
+    }
+    setWantWrite(conn, !conn.output.empty());
+}
+
+void ClientPool::setWantWrite(Connection& conn, bool want) {
+    if (conn.want_write == want) {
+        return;
+    }
+    uint32_t events = EpollEvents::IN | EpollEvents::ET | (want ? EpollEvents::OUT : 0);
+    epoll_.modify(conn.socket.getFd(), events, &conn);
+    conn.want_write = want;
+}
+
+//在途的请求不知道对端是否已处理，不自动重发，以失败回调；连接稍后重连
+void ClientPool::fail(Connection& conn, int error) {
+    if (conn.state == State::Closed) {
+        return;
+    }
+    if (conn.state == State::Connecting) {
+        std::cerr << "ClientPool: connect to " << target_.toString() << " failed: " << std::strerror(error) << std::endl;
+    }
+    epoll_.remove(conn.socket.getFd());
+    conn.socket.close();
+    conn.state = State::Closed;
+    conn.deadline_ms = nowMs() + static_cast<uint64_t>(options_.reconnect_delay_ms);
+    conn.want_write = false;
+    conn.output.clear();
+    conn.input.consume(conn.input.readable());
+    conn.input.releaseIfEmpty();
+
+    std::deque<Callback> failed;
+    failed.swap(conn.in_flight);
+    in_flight_ -= failed.size();
+    for (auto& callback : failed) {
+        complete(callback, false, std::string_view());
+    }
+    failQueuedIfUnreachable();
+}
+
+void ClientPool::dispatch() {
+    while (!queue_.empty()) {
+        Connection* conn = pickReady();
+        if (conn == nullptr) {
+            return;
+        }
+        Queued item = std::move(queue_.front());
+        queue_.pop_front();
+        conn->in_flight.push_back(std::move(item.callback));
+        in_flight_++;
+        send(*conn, item.request);
+    }
+}
+
+ClientPool::Connection* ClientPool::pickReady() {
+    Connection* best = nullptr;
+    for (auto& conn : conns_) {
+        if (conn->state != State::Ready || conn->in_flight.size() >= options_.pipeline) {
+            continue;
+        }
+        if (best == nullptr || conn->in_flight.size() < best->in_flight.size()) {
+            best = conn.get();
+        }
+    }
+    return best;
+}
+
+void ClientPool::checkTimers() {
+    uint64_t now = nowMs();
+    for (auto& conn : conns_) {
+        if (conn->state == State::Connecting && now >= conn->deadline_ms) {
+            fail(*conn, ETIMEDOUT);
+        } else if (conn->state == State::Closed && now >= conn->deadline_ms) {
+            reconnects_++;
+            connect(*conn);
+        }
+    }
+}
+
+int ClientPool::nextTimeout(int timeout_ms) const {
+    uint64_t now = nowMs();
+    int timeout = timeout_ms;
+    for (const auto& conn : conns_) {
+        if (conn->state == State::Ready) {
+            continue;
+        }
+        int due = conn->deadline_ms > now ? static_cast<int>(conn->deadline_ms - now) : 0;
+        if (timeout < 0 || due < timeout) {
+            timeout = due;
+        }
+    }
+    return timeout;
+}
+
+void ClientPool::failQueuedIfUnreachable() {
+    bool reachable = std::any_of(conns_.begin(), conns_.end(),
+                                 [](const auto& conn) { return conn->state != State::Closed; });
+    if (reachable) {
+        return;
+    }
+    std::deque<Queued> failed;
+    failed.swap(queue_);
+    for (auto& item : failed) {
+        complete(item.callback, false, std::string_view());
+    }
+}
+
+void ClientPool::complete(Callback& callback, bool ok, std::string_view response) {
+    completed_++;
+    if (callback) {
+        callback(ok, response);
+    }
+}
@@ -0,0 +1,337 @@
+#include "../../include/load_generator.h"
+#include "../../include/epoll.h"
+#include "../../include/socket.h"
+#include "../../include/socket_address.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+uint64_t nowNs() {
+    using namespace std::chrono;
+    return static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+//同一条请求报文重复若干次拼成的发送源：报文长度为周期，从任意偏移开始都能连续发出多条
+std::vector<char> buildWire(const LoadGeneratorOptions& options, size_t& wire_size) {
+    std::vector<char> message;
+    if (options.framing == LoadGeneratorOptions::Framing::LengthPrefixed) {
+        uint32_t len = static_cast<uint32_t>(options.message_size);
+        message.push_back(static_cast<char>((len >> 24) & 0xff));
+        message.push_back(static_cast<char>((len >> 16) & 0xff));
+        message.push_back(static_cast<char>((len >> 8) & 0xff));
+        message.push_back(static_cast<char>(len & 0xff));
+    }
+    for (size_t i = 0; i < options.message_size; i++) {
+        message.push_back(static_cast<char>('a' + i % 26));
+    }
+    if (options.framing == LoadGeneratorOptions::Framing::Line) {
+        message.push_back('\n');
+    }
+    wire_size = message.size();
+
+    size_t copies = std::max<size_t>(static_cast<size_t>(options.pipeline), 64 * 1024 / std::max<size_t>(wire_size, 1) + 1);
+    std::vector<char> wire;
+    wire.reserve(copies * wire_size);
+    for (size_t i = 0; i < copies; i++) {
+        wire.insert(wire.end(), message.begin(), message.end());
+    }
+    return wire;
+}
+
+struct Worker;
+
+//压测连接：回显长度与请求一致，按字节数把回复与请求一一对应
+class BenchConnection : public EpollHandler {
+public:
+    BenchConnection(Worker* worker, Socket&& socket) : worker_(worker), socket_(std::move(socket)) {}
+
+    void handleEvent(uint32_t events) override;
+
+    Socket& socket() { return socket_; }
+
+    std::deque<uint64_t> issued;    //已计划的请求的计划时间（纳秒），队首最早
+    size_t sent = 0;                //issued中已写入套接字的条数
+    size_t unsent_bytes = 0;        //已决定发送但还没写出的字节
+    size_t send_offset = 0;         //当前报文内的发送偏移
+    size_t recv_progress = 0;       //当前回复已收到的字节
+    uint64_t next_due = 0;          //开环模式下一条请求的计划时间
+    bool want_write = false;
+    bool closed = false;
+
+private:
+    Worker* worker_;
+    Socket socket_;
+};
+
+struct Worker {
+    const LoadGeneratorOptions& options;
+    LoadGeneratorResult& result;
+    Epoll epoll;
+    std::vector<char> wire;
+    size_t wire_size = 0;
+    std::vector<char> scratch;
+    uint64_t measure_start = 0;     //预热结束时刻，此后的样本才计入
+    uint64_t interval_ns = 0;       //开环模式下单个连接的请求间隔
+    std::vector<std::unique_ptr<BenchConnection>> conns;
+
+    Worker(const LoadGeneratorOptions& opts, LoadGeneratorResult& res) : options(opts), result(res), scratch(64 * 1024) {}
+
+    void issue(BenchConnection& conn, uint64_t planned) {
+        conn.issued.push_back(planned);
+        if (planned >= measure_start) {
+            result.sent++;
+        }
+    }
+
+    //在途数未达流水线深度时把已计划的请求写出去
+    void pump(BenchConnection& conn) {
+        while (conn.sent < conn.issued.size() && conn.sent < static_cast<size_t>(options.pipeline)) {
+            conn.sent++;
+            conn.unsent_bytes += wire_size;
+        }
+        flush(conn);
+    }
+
+    void flush(BenchConnection& conn) {
+        while (conn.unsent_bytes > 0) {
+            size_t len = std::min(conn.unsent_bytes, wire.size() - conn.send_offset);
+            struct iovec iov;
+            iov.iov_base = wire.data() + conn.send_offset;
+            iov.iov_len = len;
+            ssize_t n = conn.socket().sendv(std::span<const struct iovec>(&iov, 1));
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    setWantWrite(conn, true);
+                    return;
+                }
+                fail(conn);
+                return;
+            }
+            conn.unsent_bytes -= static_cast<size_t>(n);
+            conn.send_offset = (conn.send_offset + static_cast<size_t>(n)) % wire_size;
+        }
+        setWantWrite(conn, false);
+    }
+
+    void setWantWrite(BenchConnection& conn, bool want) {
+        if (conn.want_write == want || conn.closed) {
+            return;
+        }
+        uint32_t events = EpollEvents::IN | EpollEvents::ET | (want ? EpollEvents::OUT : 0);
+        epoll.modify(conn.socket().getFd(), events, &conn);
+        conn.want_write = want;
+    }
+
+    void read(BenchConnection& conn) {
+        while (!conn.closed) {
+            struct iovec iov;
+            iov.iov_base = scratch.data();
+            iov.iov_len = scratch.size();
+            ssize_t n = conn.socket().recvv(std::span<const struct iovec>(&iov, 1));
+            if (n > 0) {
+                complete(conn, static_cast<size_t>(n));
+            } else if (n == 0) {
+                fail(conn);
+            } else {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    fail(conn);
+                }
+                break;
+            }
+        }
+    }
+
+    //每凑满一条回复就弹出对应请求并记录延迟；闭环模式下立即补发一条
+    void complete(BenchConnection& conn, size_t bytes) {
+        uint64_t now = nowNs();
+        if (now >= measure_start) {
+            result.bytes += bytes;
+        }
+        conn.recv_progress += bytes;
+        while (conn.recv_progress >= wire_size && !conn.issued.empty() && conn.sent > 0) {
+            conn.recv_progress -= wire_size;
+            uint64_t planned = conn.issued.front();
+            conn.issued.pop_front();
+            conn.sent--;
+            if (planned >= measure_start) {
+                result.latency_us.record((now - planned) / 1000);
+                result.completed++;
+            }
+            if (options.rate <= 0) {
+                issue(conn, now);
+            }
+        }
+        pump(conn);
+    }
+
+    void fail(BenchConnection& conn) {
+        if (conn.closed) {
+            return;
+        }
+        conn.closed = true;
+        result.errors++;
+        epoll.remove(conn.socket().getFd());
+        conn.socket().close();
+    }
+};
+
+void BenchConnection::handleEvent(uint32_t events) {
+    if (closed) {
+        return;
+    }
+    if (events & (EpollEvents::ERR | EpollEvents::HUP)) {
+        worker_->fail(*this);
+        return;
+    }
+    if (events & EpollEvents::OUT) {
+        worker_->flush(*this);
+    }
+    if (events & EpollEvents::IN) {
+        worker_->read(*this);
+    }
+}
+
+}
+
+void LoadGeneratorResult::merge(const LoadGeneratorResult& other) {
+    latency_us.merge(other.latency_us);
+    sent += other.sent;
+    completed += other.completed;
+    bytes += other.bytes;
+    errors += other.errors;
+    elapsed = std::max(elapsed, other.elapsed);
+}
+
+bool LoadGenerator::run(LoadGeneratorResult& result) {
+    int threads = std::max(1, options_.threads);
+    int connections = std::max(threads, options_.connections);
+
+    std::vector<LoadGeneratorResult> results(static_cast<size_t>(threads));
+    std::vector<std::thread> workers;
+    std::vector<char> ok(static_cast<size_t>(threads), 0);
+
+    for (int i = 0; i < threads; i++) {
+        int count = connections / threads + (i < connections % threads ? 1 : 0);
+        workers.emplace_back([this, i, count, &results, &ok] {
+            ok[i] = runWorker(i, count, results[i]) ? 1 : 0;
+        });
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    for (int i = 0; i < threads; i++) {
+        result.merge(results[i]);
+    }
+    return std::all_of(ok.begin(), ok.end(), [](char v) { return v != 0; });
+}
+
+bool LoadGenerator::runWorker(int index, int connections, LoadGeneratorResult& result) {
+    Worker worker(options_, result);
+    if (!worker.epoll.create()) {
+        return false;
+    }
+    worker.wire = buildWire(options_, worker.wire_size);
+
+    //主机名只解析一次，全部连接复用同一个地址
+    SocketAddress target;
+    if (!SocketAddress::resolve(options_.host, options_.port, target)) {
+        return false;
+    }
+
+    for (int i = 0; i < connections; i++) {
+        Socket socket;
+        if (!socket.createSocket(SocketType::Stream, target.family()) || !socket.connect(target) ||
+            !socket.setNonBlocking()) {
+            std::cerr << "Worker " << index << ": failed to open connection " << i << std::endl;
+            return false;
+        }
+        auto conn = std::make_unique<BenchConnection>(&worker, std::move(socket));
+        if (!worker.epoll.add(conn->socket().getFd(), EpollEvents::IN | EpollEvents::ET, conn.get())) {
+            return false;
+        }
+        worker.conns.push_back(std::move(conn));
+    }
+
+    uint64_t start = nowNs();
+    worker.measure_start = start + static_cast<uint64_t>(options_.warmup * 1e9);
+    uint64_t end = worker.measure_start + static_cast<uint64_t>(options_.duration * 1e9);
+
+    //开环：总速率平均分到每个连接，各连接的起始时间错开，避免同一时刻集中发出
+    if (options_.rate > 0) {
+        double per_conn = options_.rate / (options_.connections > 0 ? options_.connections : 1);
+        worker.interval_ns = static_cast<uint64_t>(1e9 / std::max(per_conn, 1e-9));
+        for (size_t i = 0; i < worker.conns.size(); i++) {
+            worker.conns[i]->next_due = start + worker.interval_ns * i / worker.conns.size();
+        }
+    } else {
+        for (auto& conn : worker.conns) {
+            for (int j = 0; j < options_.pipeline; j++) {
+                worker.issue(*conn, start);
+            }
+            worker.pump(*conn);
+        }
+    }
+
+    std::vector<struct epoll_event> events(1024);
+    while (true) {
+        uint64_t now = nowNs();
+        if (now >= end) {
+            break;
+        }
+
+        if (options_.rate > 0) {
+            for (auto& conn : worker.conns) {
+                if (conn->closed) {
+                    continue;
+                }
+                bool issued = false;
+                while (conn->next_due <= now) {
+                    worker.issue(*conn, conn->next_due);
+                    conn->next_due += worker.interval_ns;
+                    issued = true;
+                }
+                if (issued) {
+                    worker.pump(*conn);
+                }
+            }
+        }
+
+        int n = worker.epoll.wait(events, options_.rate > 0 ? 1 : 100);
+        if (n > 0) {
+            Epoll::dispatch(std::span<const struct epoll_event>(events.data(), static_cast<size_t>(n)));
+        }
+    }
+
+    result.elapsed = static_cast<double>(nowNs() - worker.measure_start) / 1e9;
+    return true;
+}
+
+void LoadGenerator::printReport(const LoadGeneratorOptions& options, const LoadGeneratorResult& result) {
+    const Histogram& h = result.latency_us;
+    double elapsed = result.elapsed > 0 ? result.elapsed : 1;
+
+    std::printf("\n=== Benchmark Result ===\n");
+    std::printf("connections: %d, threads: %d, message: %zu bytes, pipeline: %d, rate: %s\n",
+                options.connections, options.threads, options.message_size, options.pipeline,
+                options.rate > 0 ? std::to_string(static_cast<long long>(options.rate)).c_str() : "closed-loop");
+    std::printf("duration: %.2f s, sent: %llu, completed: %llu, errors: %llu\n", elapsed,
+                static_cast<unsigned long long>(result.sent), static_cast<unsigned long long>(result.completed),
+                static_cast<unsigned long long>(result.errors));
+    std::printf("throughput: %.0f msg/s, %.2f MB/s\n", static_cast<double>(result.completed) / elapsed,
+                static_cast<double>(result.bytes) / elapsed / (1024.0 * 1024.0));
+    std::printf("latency (us): min %llu, mean %.1f, p50 %llu, p90 %llu, p99 %llu, p99.9 %llu, max %llu\n",
+                static_cast<unsigned long long>(h.min()), h.mean(),
+                static_cast<unsigned long long>(h.percentile(50)), static_cast<unsigned long long>(h.percentile(90)),
+                static_cast<unsigned long long>(h.percentile(99)), static_cast<unsigned long long>(h.percentile(99.9)),
+                static_cast<unsigned long long>(h.max()));
+}
@@ -0,0 +1,251 @@
+#include "../../include/async_logger.h"
+#include "spdlog/sinks/sink.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+std::atomic<uint64_t> next_instance_id{1};
+
+//当前线程最近一次使用的日志器及其队列
+thread_local uint64_t local_owner = 0;
+thread_local LogQueue* local_queue = nullptr;
+
+size_t roundUpPowerOfTwo(size_t n) {
+    size_t v = 1;
+    while (v < n) {
+        v <<= 1;
+    }
+    return v;
+}
+
+}
+
+LogQueue::LogQueue(size_t capacity)
+    : records_(roundUpPowerOfTwo(std::max<size_t>(capacity, 2))), mask_(records_.size() - 1),
+      head_(0), tail_(0), cached_head_(0), dropped_(0) {}
+
+LogRecord* LogQueue::reserve() {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == records_.size()) {
+        cached_head_ = head_.load(std::memory_order_acquire);
+        if (tail - cached_head_ == records_.size()) {
+            return nullptr;
+        }
+    }
+    return &records_[tail & mask_];
+}
+
+void LogQueue::commit() {
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+LogRecord* LogQueue::front() {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return &records_[head & mask_];
+}
+
+void LogQueue::pop() {
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+AsyncLogger::AsyncLogger(std::shared_ptr<spdlog::logger> sink_logger, Mode mode, size_t queue_capacity)
+    : sink_logger_(std::move(sink_logger)), mode_(mode), queue_capacity_(queue_capacity),
+      instance_id_(next_instance_id.fetch_add(1)), level_(sink_logger_->level()), queue_count_(0),
+      running_(false), reported_dropped_(0) {
+    for (auto& s : sampling_) {
+        s.store(1, std::memory_order_relaxed);
+    }
+    if (mode_ == Mode::Async) {
+        running_ = true;
+        worker_ = std::thread([this] { backgroundLoop(); });
+    }
+}
+
+AsyncLogger::~AsyncLogger() {
+    stop();
+}
+
+void AsyncLogger::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    //每次drain每个队列最多处理一批，循环到全部写完
+    while (drain() > 0) {
+    }
+    sink_logger_->flush();
+}
+
+void AsyncLogger::setSampling(spdlog::level::level_enum level, uint32_t one_in) {
+    sampling_[level].store(std::max<uint32_t>(one_in, 1), std::memory_order_relaxed);
+}
+
+uint64_t AsyncLogger::dropped() const {
+    std::lock_guard<std::mutex> lock(queues_mutex_);
+    uint64_t total = 0;
+    for (const auto& q : queues_) {
+        total += q->dropped();
+    }
+    return total;
+}
+
+//线程本地缓存只记住最近使用的日志器；换用其他日志器后再回来时加锁查回该线程原有的队列，
+//每个线程在每个日志器上只注册一个队列
+LogQueue* AsyncLogger::localQueue() {
+    if (local_owner == instance_id_) {
+        return local_queue;
+    }
+    LogQueue* raw = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(queues_mutex_);
+        LogQueue*& slot = thread_queues_[std::this_thread::get_id()];
+        if (slot == nullptr) {
+            queues_.push_back(std::make_unique<LogQueue>(queue_capacity_));
+            slot = queues_.back().get();
+            queue_count_.store(queues_.size(), std::memory_order_release);
+        }
+        raw = slot;
+    }
+    local_owner = instance_id_;
+    local_queue = raw;
+    return raw;
+}
+
+void AsyncLogger::captureText(LogRecord& record, std::string_view text) {
+    LogRecord::Arg& arg = record.args[record.arg_count++];
+    size_t room = LogRecord::TEXT_CAPACITY - record.text_used;
+    size_t len = std::min(text.size(), room);
+    std::memcpy(record.text + record.text_used, text.data(), len);
+
+    arg.type = LogRecord::ArgType::Text;
+    arg.truncated = len < text.size();
+    arg.text.offset = record.text_used;
+    arg.text.length = static_cast<uint16_t>(len);
+    record.text_used = static_cast<uint16_t>(record.text_used + len);
+}
+
+//按"{}"依次代入参数，"{{"和"}}"为转义，然后交给spdlog的sinks，时间和线程号用记录时的值
+void AsyncLogger::write(const LogRecord& record, std::string& line) {
+    line.clear();
+    size_t next = 0;
+    char number[32];
+
+    for (const char* p = record.format; *p != '\0'; p++) {
+        if (p[0] == '{' && p[1] == '{') {
+            line.push_back('{');
+            p++;
+        } else if (p[0] == '}' && p[1] == '}') {
+            line.push_back('}');
+            p++;
+        } else if (p[0] == '{' && p[1] == '}') {
+            p++;
+            if (next >= record.arg_count) {
+                continue;
+            }
+            const LogRecord::Arg& arg = record.args[next++];
+            int n = 0;
+            switch (arg.type) {
+            case LogRecord::ArgType::Int:
+                n = std::snprintf(number, sizeof(number), "%lld", static_cast<long long>(arg.i));
+                line.append(number, static_cast<size_t>(n));
+                break;
+            case LogRecord::ArgType::Uint:
+                n = std::snprintf(number, sizeof(number), "%llu", static_cast<unsigned long long>(arg.u));
+                line.append(number, static_cast<size_t>(n));
+                break;
+            case LogRecord::ArgType::Double:
+                n = std::snprintf(number, sizeof(number), "%g", arg.d);
+                line.append(number, static_cast<size_t>(n));
+                break;
+            case LogRecord::ArgType::Bool:
+                line.append(arg.u ? "true" : "false");
+                break;
+            case LogRecord::ArgType::Text:
+                line.append(record.text + arg.text.offset, arg.text.length);
+                if (arg.truncated) {
+                    line.append("...");
+                }
+                break;
+            }
+        } else {
+            line.push_back(*p);
+        }
+    }
+
+    auto time = spdlog::log_clock::time_point(
+        std::chrono::duration_cast<spdlog::log_clock::duration>(std::chrono::nanoseconds(record.time_ns)));
+    spdlog::details::log_msg msg(time, spdlog::source_loc{}, sink_logger_->name(), record.level,
+                                 spdlog::string_view_t(line.data(), line.size()));
+    msg.thread_id = record.thread_id;
+    for (auto& sink : sink_logger_->sinks()) {
+        if (sink->should_log(record.level)) {
+            sink->log(msg);
+        }
+    }
+}
+
+size_t AsyncLogger::drain() {
+    size_t count = queue_count_.load(std::memory_order_acquire);
+    if (snapshot_.size() != count) {
+        std::lock_guard<std::mutex> lock(queues_mutex_);
+        snapshot_.clear();
+        for (const auto& q : queues_) {
+            snapshot_.push_back(q.get());
+        }
+    }
+
+    size_t written = 0;
+    uint64_t dropped = 0;
+    for (LogQueue* queue : snapshot_) {
+        //每个队列一次最多处理一批，避免一个忙线程饿死其他线程的日志
+        for (int i = 0; i < 256; i++) {
+            LogRecord* record = queue->front();
+            if (record == nullptr) {
+                break;
+            }
+            write(*record, line_);
+            queue->pop();
+            written++;
+        }
+        dropped += queue->dropped();
+    }
+
+    if (dropped > reported_dropped_) {
+        LogRecord record;
+        record.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        record.format = "Log queue full, dropped {} record(s)";
+        record.thread_id = spdlog::details::os::thread_id();
+        record.level = spdlog::level::warn;
+        record.arg_count = 1;
+        record.text_used = 0;
+        record.args[0].type = LogRecord::ArgType::Uint;
+        record.args[0].u = dropped - reported_dropped_;
+        write(record, line_);
+        reported_dropped_ = dropped;
+    }
+    return written;
+}
+
+//有记录时连续处理；空闲时刷盘并短暂休眠，不在生产者一侧做任何唤醒
+void AsyncLogger::backgroundLoop() {
+    bool dirty = false;
+    while (running_.load(std::memory_order_acquire)) {
+        if (drain() > 0) {
+            dirty = true;
+            continue;
+        }
+        if (dirty) {
+            sink_logger_->flush();
+            dirty = false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
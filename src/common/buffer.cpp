@@ -0,0 +1,202 @@
+#include "../../include/buffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+//环形缓冲区依赖掩码取模，块大小向上取整为2的幂
+static size_t roundUpPowerOfTwo(size_t n) {
+    size_t v = 1;
+    while (v < n) {
+        v <<= 1;
+    }
+    return v;
+}
+
+BufferPool::BufferPool(size_t block_size, size_t blocks_per_slab)
+    : block_size_(roundUpPowerOfTwo(block_size)), blocks_per_slab_(blocks_per_slab > 0 ? blocks_per_slab : 1) {
+    grow();
+}
+
+//一次申请一整块slab并切分，避免每个块单独调用malloc
+void BufferPool::grow() {
+    slabs_.emplace_back(new char[block_size_ * blocks_per_slab_]);
+    char* base = slabs_.back().get();
+    free_list_.reserve(free_list_.size() + blocks_per_slab_);
+    for (size_t i = 0; i < blocks_per_slab_; i++) {
+        free_list_.push_back(base + i * block_size_);
+    }
+}
+
+char* BufferPool::acquire() {
+    if (free_list_.empty()) {
+        grow();
+    }
+    char* block = free_list_.back();
+    free_list_.pop_back();
+    return block;
+}
+
+void BufferPool::release(char* block) {
+    if (block != nullptr) {
+        free_list_.push_back(block);
+    }
+}
+
+RingBuffer::RingBuffer(BufferPool* pool)
+    : pool_(pool), data_(nullptr), capacity_(0), head_(0), tail_(0), scanned_(0) {}
+
+RingBuffer::~RingBuffer() {
+    if (data_ != nullptr && pool_ != nullptr) {
+        pool_->release(data_);
+    }
+}
+
+RingBuffer::RingBuffer(RingBuffer&& other) noexcept
+    : pool_(other.pool_), data_(other.data_), capacity_(other.capacity_), head_(other.head_), tail_(other.tail_), scanned_(other.scanned_) {
+    other.data_ = nullptr;
+    other.capacity_ = 0;
+    other.head_ = other.tail_ = 0;
+    other.scanned_ = 0;
+}
+
+RingBuffer& RingBuffer::operator=(RingBuffer&& other) noexcept {
+    if (this != &other) {
+        if (data_ != nullptr && pool_ != nullptr) {
+            pool_->release(data_);
+        }
+        pool_ = other.pool_;
+        data_ = other.data_;
+        capacity_ = other.capacity_;
+        head_ = other.head_;
+        tail_ = other.tail_;
+        scanned_ = other.scanned_;
+        other.data_ = nullptr;
+        other.capacity_ = 0;
+        other.head_ = other.tail_ = 0;
+        other.scanned_ = 0;
+    }
+    return *this;
+}
+
+bool RingBuffer::reserve() {
+    if (data_ != nullptr) {
+        return true;
+    }
+    if (pool_ == nullptr) {
+        return false;
+    }
+    data_ = pool_->acquire();
+    capacity_ = pool_->blockSize();
+    head_ = tail_ = 0;
+    return true;
+}
+
+void RingBuffer::releaseIfEmpty() {
+    if (data_ != nullptr && empty() && pool_ != nullptr) {
+        pool_->release(data_);
+        data_ = nullptr;
+        capacity_ = 0;
+        head_ = tail_ = 0;
+    }
+}
+
+int RingBuffer::readableSegments(struct iovec iov[2]) const {
+    size_t len = readable();
+    if (len == 0) {
+        return 0;
+    }
+
+    size_t start = mask(head_);
+    size_t first = std::min(len, capacity_ - start);
+    iov[0].iov_base = data_ + start;
+    iov[0].iov_len = first;
+    if (first == len) {
+        return 1;
+    }
+    iov[1].iov_base = data_;
+    iov[1].iov_len = len - first;
+    return 2;
+}
+
+int RingBuffer::writableSegments(struct iovec iov[2]) {
+    if (!reserve()) {
+        return 0;
+    }
+    size_t len = writable();
+    if (len == 0) {
+        return 0;
+    }
+
+    size_t start = mask(tail_);
+    size_t first = std::min(len, capacity_ - start);
+    iov[0].iov_base = data_ + start;
+    iov[0].iov_len = first;
+    if (first == len) {
+        return 1;
+    }
+    iov[1].iov_base = data_;
+    iov[1].iov_len = len - first;
+    return 2;
+}
+
+void RingBuffer::consume(size_t n) {
+    head_ += std::min(n, readable());
+    scanned_ = 0;
+    //读空后复位，使下一次写入从块首开始，尽量避免环绕
+    if (head_ == tail_) {
+        head_ = tail_ = 0;
+    }
+}
+
+void RingBuffer::linearize() {
+    size_t start = mask(head_);
+    if (data_ == nullptr || start + readable() <= capacity_) {
+        return;
+    }
+    std::rotate(data_, data_ + start, data_ + capacity_);
+    tail_ = readable();
+    head_ = 0;
+}
+
+size_t RingBuffer::peek(size_t offset, char* dst, size_t len) const {
+    if (offset >= readable()) {
+        return 0;
+    }
+    len = std::min(len, readable() - offset);
+
+    size_t start = mask(head_ + offset);
+    size_t first = std::min(len, capacity_ - start);
+    std::memcpy(dst, data_ + start, first);
+    if (first < len) {
+        std::memcpy(dst + first, data_, len - first);
+    }
+    return len;
+}
+
+size_t RingBuffer::append(const char* data, size_t len) {
+    struct iovec iov[2];
+    int cnt = writableSegments(iov);
+    size_t copied = 0;
+    for (int i = 0; i < cnt && copied < len; i++) {
+        size_t n = std::min(len - copied, iov[i].iov_len);
+        std::memcpy(iov[i].iov_base, data + copied, n);
+        copied += n;
+    }
+    produce(copied);
+    return copied;
+}
+
+size_t RingBuffer::append(const RingBuffer& other) {
+    struct iovec iov[2];
+    int cnt = other.readableSegments(iov);
+    size_t copied = 0;
+    for (int i = 0; i < cnt; i++) {
+        size_t n = append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+        copied += n;
+        if (n < iov[i].iov_len) {
+            break;
+        }
+    }
+    return copied;
+}
@@ -0,0 +1,130 @@
+#include "../../include/codec.h"
+#include "../../include/buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+std::string_view FrameCodec::view(const RingBuffer& input, size_t offset, size_t len) {
+    struct iovec iov[2];
+    int cnt = input.readableSegments(iov);
+    if (cnt == 0 || len == 0) {
+        return std::string_view();
+    }
+
+    //整段都在第一段或第二段内时直接返回视图
+    if (offset + len <= iov[0].iov_len) {
+        return std::string_view(static_cast<const char*>(iov[0].iov_base) + offset, len);
+    }
+    if (cnt > 1 && offset >= iov[0].iov_len) {
+        return std::string_view(static_cast<const char*>(iov[1].iov_base) + (offset - iov[0].iov_len), len);
+    }
+
+    scratch_.resize(len);
+    input.peek(offset, scratch_.data(), len);
+    return std::string_view(scratch_.data(), len);
+}
+
+FrameCodec::DecodeResult LengthPrefixedCodec::decode(const RingBuffer& input, Frame& frame) {
+    if (input.readable() < HEADER_SIZE) {
+        return DecodeResult::NeedMore;
+    }
+
+    unsigned char header[HEADER_SIZE];
+    input.peek(0, reinterpret_cast<char*>(header), HEADER_SIZE);
+    size_t len = (static_cast<size_t>(header[0]) << 24) | (static_cast<size_t>(header[1]) << 16) |
+                 (static_cast<size_t>(header[2]) << 8) | static_cast<size_t>(header[3]);
+
+    if (len > max_frame_) {
+        return DecodeResult::Error;
+    }
+    if (input.readable() < HEADER_SIZE + len) {
+        return DecodeResult::NeedMore;
+    }
+
+    frame.payload = view(input, HEADER_SIZE, len);
+    frame.wire_size = HEADER_SIZE + len;
+    return DecodeResult::Frame;
+}
+
+int LengthPrefixedCodec::encode(std::string_view payload, struct iovec iov[3]) {
+    uint32_t len = static_cast<uint32_t>(payload.size());
+    header_[0] = static_cast<char>((len >> 24) & 0xff);
+    header_[1] = static_cast<char>((len >> 16) & 0xff);
+    header_[2] = static_cast<char>((len >> 8) & 0xff);
+    header_[3] = static_cast<char>(len & 0xff);
+
+    iov[0].iov_base = header_;
+    iov[0].iov_len = HEADER_SIZE;
+    if (payload.empty()) {
+        return 1;
+    }
+    iov[1].iov_base = const_cast<char*>(payload.data());
+    iov[1].iov_len = payload.size();
+    return 2;
+}
+
+bool LengthPrefixedCodec::encodeEnvelope(size_t payload_len, struct iovec& header, struct iovec& trailer) {
+    if (payload_len > UINT32_MAX) {
+        return false;
+    }
+    uint32_t len = static_cast<uint32_t>(payload_len);
+    header_[0] = static_cast<char>((len >> 24) & 0xff);
+    header_[1] = static_cast<char>((len >> 16) & 0xff);
+    header_[2] = static_cast<char>((len >> 8) & 0xff);
+    header_[3] = static_cast<char>(len & 0xff);
+
+    header.iov_base = header_;
+    header.iov_len = HEADER_SIZE;
+    trailer.iov_base = nullptr;
+    trailer.iov_len = 0;
+    return true;
+}
+
+//在两段可读区域中依次用memchr查找分隔符，跳过上次调用已查过的前缀，部分到达的长行每个字节只查一次
+FrameCodec::DecodeResult DelimiterCodec::decode(const RingBuffer& input, Frame& frame) {
+    struct iovec iov[2];
+    int cnt = input.readableSegments(iov);
+    size_t skip = std::min(input.scanned(), input.readable());
+    size_t offset = 0;
+    for (int i = 0; i < cnt; i++) {
+        if (skip >= iov[i].iov_len) {
+            skip -= iov[i].iov_len;
+            offset += iov[i].iov_len;
+            continue;
+        }
+        const char* base = static_cast<const char*>(iov[i].iov_base);
+        const void* pos = std::memchr(base + skip, delimiter_, iov[i].iov_len - skip);
+        if (pos != nullptr) {
+            size_t len = offset + static_cast<size_t>(static_cast<const char*>(pos) - base);
+            if (len > max_frame_) return DecodeResult::Error;
+            frame.payload = view(input, 0, len);
+            frame.wire_size = len + 1;
+            return DecodeResult::Frame;
+        }
+        skip = 0;
+        offset += iov[i].iov_len;
+    }
+    if (input.readable() > max_frame_) return DecodeResult::Error;
+    input.setScanned(input.readable());
+    return DecodeResult::NeedMore;
+}
+
+int DelimiterCodec::encode(std::string_view payload, struct iovec iov[3]) {
+    int cnt = 0;
+    if (!payload.empty()) {
+        iov[cnt].iov_base = const_cast<char*>(payload.data());
+        iov[cnt].iov_len = payload.size();
+        cnt++;
+    }
+    iov[cnt].iov_base = &delimiter_;
+    iov[cnt].iov_len = 1;
+    return cnt + 1;
+}
+
+bool DelimiterCodec::encodeEnvelope(size_t, struct iovec& header, struct iovec& trailer) {
+    header.iov_base = nullptr;
+    header.iov_len = 0;
+    trailer.iov_base = &delimiter_;
+    trailer.iov_len = 1;
+    return true;
+}
@@ -0,0 +1,60 @@
+#include "../../include/coroutine.h"
+
+#include <new>
+
+thread_local FramePool* FramePool::current_ = nullptr;
+
+FramePool::~FramePool() {
+    for (size_t c = 0; c < CLASSES; c++) {
+        while (free_[c] != nullptr) {
+            FreeBlock* block = free_[c];
+            free_[c] = block->next;
+            ::operator delete(block);
+        }
+    }
+}
+
+void* FramePool::allocate(size_t size) {
+    size_t total = size + sizeof(Header);
+    size_t size_class = 0;
+    while (size_class < CLASSES && total > (size_t(1) << (MIN_CLASS_SHIFT + size_class))) {
+        size_class++;
+    }
+
+    FramePool* pool = current_;
+    void* block = nullptr;
+    if (pool == nullptr || size_class == CLASSES) {
+        pool = nullptr;
+        block = ::operator new(total);
+    } else if (pool->free_[size_class] != nullptr) {
+        FreeBlock* head = pool->free_[size_class];
+        pool->free_[size_class] = head->next;
+        block = head;
+        pool->reused_++;
+    } else {
+        block = ::operator new(size_t(1) << (MIN_CLASS_SHIFT + size_class));
+    }
+    if (pool != nullptr) {
+        pool->live_++;
+    }
+
+    Header* header = new (block) Header{pool, static_cast<uint32_t>(size_class)};
+    return header + 1;
+}
+
+void FramePool::deallocate(void* frame) noexcept {
+    if (frame == nullptr) {
+        return;
+    }
+    Header* header = static_cast<Header*>(frame) - 1;
+    FramePool* pool = header->owner;
+    if (pool == nullptr) {
+        ::operator delete(header);
+        return;
+    }
+
+    uint32_t size_class = header->size_class;
+    FreeBlock* block = new (header) FreeBlock{pool->free_[size_class]};
+    pool->free_[size_class] = block;
+    pool->live_--;
+}
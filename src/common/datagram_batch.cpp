@@ -0,0 +1,52 @@
+#include "../../include/datagram_batch.h"
+
+#include <cstring>
+
+DatagramBatch::DatagramBatch(size_t capacity, size_t datagram_size)
+    : capacity_(capacity > 0 ? capacity : 1), datagram_size_(datagram_size), count_(0),
+      storage_(new char[capacity_ * datagram_size_]), iovs_(new struct iovec[capacity_]),
+      headers_(new struct mmsghdr[capacity_]), addrs_(new struct sockaddr_storage[capacity_]) {
+    std::memset(headers_.get(), 0, sizeof(struct mmsghdr) * capacity_);
+    for (size_t i = 0; i < capacity_; i++) {
+        iovs_[i].iov_base = storage_.get() + i * datagram_size_;
+        iovs_[i].iov_len = datagram_size_;
+        headers_[i].msg_hdr.msg_iov = &iovs_[i];
+        headers_[i].msg_hdr.msg_iovlen = 1;
+        headers_[i].msg_hdr.msg_name = &addrs_[i];
+        headers_[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+    }
+}
+
+void DatagramBatch::prepareReceive() {
+    for (size_t i = 0; i < capacity_; i++) {
+        iovs_[i].iov_len = datagram_size_;
+        headers_[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+        headers_[i].msg_hdr.msg_flags = 0;
+        headers_[i].msg_len = 0;
+    }
+    count_ = 0;
+}
+
+std::string_view DatagramBatch::data(size_t i) const {
+    return std::string_view(static_cast<const char*>(iovs_[i].iov_base), headers_[i].msg_len);
+}
+
+bool DatagramBatch::push(const char* data, size_t len, const struct sockaddr* addr, socklen_t addr_len) {
+    if (count_ == capacity_ || len > datagram_size_ || addr_len > sizeof(struct sockaddr_storage)) {
+        return false;
+    }
+
+    std::memcpy(iovs_[count_].iov_base, data, len);
+    iovs_[count_].iov_len = len;
+    std::memcpy(&addrs_[count_], addr, addr_len);
+    headers_[count_].msg_hdr.msg_namelen = addr_len;
+    count_++;
+    return true;
+}
+
+//recvmmsg已经填好了每个槽位的来源地址，只需把iov长度改为实际收到的长度
+void DatagramBatch::prepareReply() {
+    for (size_t i = 0; i < count_; i++) {
+        iovs_[i].iov_len = headers_[i].msg_len;
+    }
+}
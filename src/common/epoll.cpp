@@ -36,8 +36,7 @@ bool Epoll::create() {
     return true;
 }
 
-//添加监听
-bool Epoll::add(int fd, uint32_t events) {
+bool Epoll::control(int op, int fd, struct epoll_event* ev) {
     if (!is_created_) {
         std::cerr << "Epoll not created" << std::endl;
         return false;
@@ -47,11 +46,7 @@ bool Epoll::add(int fd, uint32_t events) {
         return false;
     }
 
-    struct epoll_event ev;
-    ev.events = events;
-    ev.data.fd = fd;
-
-    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    if (epoll_ctl(epoll_fd_, op, fd, ev) < 0) {
         std::cerr << "epoll_ctl error" << std::endl;
         return false;
     }
@@ -59,73 +54,74 @@ bool Epoll::add(int fd, uint32_t events) {
     return true;
 }
 
-bool Epoll::modify(int fd, uint32_t events) {
-    if (!is_created_) {
-        std::cerr << "Epoll not created" << std::endl;
-        return false;
-    }
+//添加监听
+bool Epoll::add(int fd, uint32_t events) {
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.fd = fd;
+    return control(EPOLL_CTL_ADD, fd, &ev);
+}
 
-    if (fd < 0) {
-        std::cerr << "Invalid fd" << std::endl;
-        return false;
-    }
+bool Epoll::add(int fd, uint32_t events, EpollHandler* handler) {
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.ptr = handler;
+    return control(EPOLL_CTL_ADD, fd, &ev);
+}
 
+bool Epoll::modify(int fd, uint32_t events) {
     struct epoll_event ev;
     ev.events = events;
     ev.data.fd = fd;
+    return control(EPOLL_CTL_MOD, fd, &ev);
+}
 
-    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) < 0) {
-        std::cerr << "epoll_ctl error" << std::endl;
-        return false;
-    }
-
-    return true;
+bool Epoll::modify(int fd, uint32_t events, EpollHandler* handler) {
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.ptr = handler;
+    return control(EPOLL_CTL_MOD, fd, &ev);
 }
 
 bool Epoll::remove(int fd) {
-    if (!is_created_) {
-        std::cerr << "Epoll not created" << std::endl;
-        return false;
-    }
-
-    if (fd < 0) {
-        std::cerr << "Invalid fd" << std::endl;
-        return false;
-    }
+    return control(EPOLL_CTL_DEL, fd, nullptr);
+}
 
-    if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr) < 0) {
-        std::cerr << "epoll_ctl error" << std::endl;
-        return false;
-    }
+std::vector<struct epoll_event> Epoll::wait(int timeout, int max_events) {
+    std::vector<struct epoll_event> events(static_cast<size_t>(max_events > 0 ? max_events : 1));
 
-    return true;
+    int nfds = wait(std::span<struct epoll_event>(events), timeout);
+    events.resize(nfds > 0 ? static_cast<size_t>(nfds) : 0);
+    return events;
 }
 
-std::vector<struct epoll_event> Epoll::wait(int timeout) {
-    std::vector<struct epoll_event> events;
+//不做任何拷贝与分配，缓冲区由调用方在事件循环外预先分配并反复使用
+int Epoll::wait(std::span<struct epoll_event> events, int timeout) {
     if (!is_created_) {
         std::cerr << "Epoll not created" << std::endl;
-        return events;
+        return -1;
     }
 
-    const int MAX_EVENTS = 1024;
-    struct epoll_event ev_list[MAX_EVENTS];
-
-    int nfds = epoll_wait(epoll_fd_, ev_list, MAX_EVENTS, timeout);
+    int nfds = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), timeout);
 
     if (nfds < 0) {
         if (errno == EINTR) {
-            return events;
+            return 0;
         }
         std::cerr << "epoll_wait error" << std::endl;
-        return events;
+        return -1;
     }
 
-    events.reserve(nfds);
-    for (int i = 0; i < nfds; i++) {
-        events.emplace_back(ev_list[i]);
+    return nfds;
+}
+
+void Epoll::dispatch(std::span<const struct epoll_event> events) {
+    for (const auto& ev : events) {
+        auto* handler = static_cast<EpollHandler*>(ev.data.ptr);
+        if (handler != nullptr) {
+            handler->handleEvent(ev.events);
+        }
     }
-    return events;
 }
 
 void Epoll::close() {
@@ -0,0 +1,83 @@
+#include "../../include/histogram.h"
+
+#include <algorithm>
+#include <limits>
+
+//小于2^bits的值每个值一个桶；更大的值按最高位所在的区间分组，每组half_count_个子桶
+Histogram::Histogram(int sub_bucket_bits)
+    : sub_bucket_bits_(std::clamp(sub_bucket_bits, 2, 16)),
+      sub_bucket_count_(static_cast<uint64_t>(1) << sub_bucket_bits_),
+      half_count_(sub_bucket_count_ / 2),
+      counts_(static_cast<size_t>(sub_bucket_count_ + (64 - sub_bucket_bits_) * half_count_), 0),
+      count_(0), sum_(0), min_(std::numeric_limits<uint64_t>::max()), max_(0) {}
+
+size_t Histogram::indexOf(uint64_t value) const {
+    if (value < sub_bucket_count_) {
+        return static_cast<size_t>(value);
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - (sub_bucket_bits_ - 1);
+    uint64_t sub = value >> shift;      //落在[half_count_, sub_bucket_count_)
+    return static_cast<size_t>(sub_bucket_count_ + static_cast<uint64_t>(shift - 1) * half_count_ + (sub - half_count_));
+}
+
+uint64_t Histogram::upperBound(size_t index) const {
+    if (index < sub_bucket_count_) {
+        return index;
+    }
+    uint64_t k = index - sub_bucket_count_;
+    int shift = static_cast<int>(k / half_count_) + 1;
+    uint64_t sub = k % half_count_ + half_count_;
+    return ((sub + 1) << shift) - 1;
+}
+
+void Histogram::record(uint64_t value) {
+    record(value, 1);
+}
+
+void Histogram::record(uint64_t value, uint64_t count) {
+    counts_[indexOf(value)] += count;
+    count_ += count;
+    sum_ += value * count;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+}
+
+void Histogram::merge(const Histogram& other) {
+    if (other.counts_.size() != counts_.size()) {
+        return;
+    }
+    for (size_t i = 0; i < counts_.size(); i++) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+void Histogram::reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    count_ = 0;
+    sum_ = 0;
+    min_ = std::numeric_limits<uint64_t>::max();
+    max_ = 0;
+}
+
+uint64_t Histogram::percentile(double p) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    p = std::clamp(p, 0.0, 100.0);
+    uint64_t target = static_cast<uint64_t>(p / 100.0 * static_cast<double>(count_) + 0.5);
+    target = std::clamp<uint64_t>(target, 1, count_);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); i++) {
+        seen += counts_[i];
+        if (seen >= target) {
+            return std::min(upperBound(i), max_);
+        }
+    }
+    return max_;
+}
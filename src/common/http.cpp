@@ -0,0 +1,212 @@
+#include "../../include/http.h"
+
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        char x = a[i];
+        char y = b[i];
+        if (x >= 'A' && x <= 'Z') {
+            x = static_cast<char>(x - 'A' + 'a');
+        }
+        if (y >= 'A' && y <= 'Z') {
+            y = static_cast<char>(y - 'A' + 'a');
+        }
+        if (x != y) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+//逗号分隔的头部值中是否含有某个记号，例如Connection: keep-alive, Upgrade
+bool hasToken(std::string_view value, std::string_view token) {
+    while (!value.empty()) {
+        size_t comma = value.find(',');
+        if (equalsIgnoreCase(trim(value.substr(0, comma)), token)) {
+            return true;
+        }
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        value.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+//取出一行（不含CRLF），pos移到下一行开头；也接受只有LF的行尾
+std::string_view nextLine(std::string_view data, size_t& pos) {
+    size_t end = data.find('\n', pos);
+    std::string_view line = data.substr(pos, end - pos);
+    pos = end + 1;
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    return line;
+}
+
+}
+
+std::string_view HttpRequest::header(std::string_view name) const {
+    for (size_t i = 0; i < header_count; i++) {
+        if (equalsIgnoreCase(headers[i].name, name)) {
+            return headers[i].value;
+        }
+    }
+    return std::string_view();
+}
+
+std::string_view HttpRequest::path() const {
+    return target.substr(0, target.find('?'));
+}
+
+HttpParser::Result HttpParser::parse(std::string_view data, HttpRequest& request) {
+    //头部以空行结束；从上次扫描的位置往回退3字节，防止结束标记跨越两次到达的数据
+    size_t from = scanned_ > 3 ? scanned_ - 3 : 0;
+    size_t head_end = std::string_view::npos;
+    for (size_t i = data.find('\n', from); i != std::string_view::npos; i = data.find('\n', i + 1)) {
+        if (i + 1 < data.size() && data[i + 1] == '\n') {
+            head_end = i + 2;
+            break;
+        }
+        if (i + 2 < data.size() && data[i + 1] == '\r' && data[i + 2] == '\n') {
+            head_end = i + 3;
+            break;
+        }
+    }
+    if (head_end == std::string_view::npos) {
+        scanned_ = data.size();
+        if (data.size() >= max_request_) {
+            return fail(431);
+        }
+        return Result::NeedMore;
+    }
+    if (head_end > max_request_) {
+        return fail(431);
+    }
+
+    size_t pos = 0;
+    std::string_view line = nextLine(data, pos);
+    size_t sp1 = line.find(' ');
+    size_t sp2 = sp1 == std::string_view::npos ? sp1 : line.find(' ', sp1 + 1);
+    if (sp2 == std::string_view::npos || sp1 == 0 || sp2 == sp1 + 1) {
+        return fail(400);
+    }
+    request.method = line.substr(0, sp1);
+    request.target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    std::string_view version = line.substr(sp2 + 1);
+    if (version.size() != 8 || version.substr(0, 7) != "HTTP/1." || version[7] < '0' || version[7] > '9') {
+        return fail(505);
+    }
+    request.minor_version = version[7] - '0';
+
+    request.header_count = 0;
+    size_t content_length = 0;
+    bool keep_alive = request.minor_version >= 1;
+    while (pos < head_end) {
+        line = nextLine(data, pos);
+        if (line.empty()) {
+            break;
+        }
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos || colon == 0) {
+            return fail(400);
+        }
+        if (request.header_count == HttpRequest::MAX_HEADERS) {
+            return fail(431);
+        }
+        HttpRequest::Header& h = request.headers[request.header_count++];
+        h.name = line.substr(0, colon);
+        h.value = trim(line.substr(colon + 1));
+
+        if (equalsIgnoreCase(h.name, "content-length")) {
+            const char* end = h.value.data() + h.value.size();
+            auto [ptr, ec] = std::from_chars(h.value.data(), end, content_length);
+            if (ec != std::errc() || ptr != end || h.value.empty()) {
+                return fail(400);
+            }
+        } else if (equalsIgnoreCase(h.name, "transfer-encoding")) {
+            return fail(501);
+        } else if (equalsIgnoreCase(h.name, "connection")) {
+            if (hasToken(h.value, "close")) {
+                keep_alive = false;
+            } else if (hasToken(h.value, "keep-alive")) {
+                keep_alive = true;
+            }
+        }
+    }
+
+    if (content_length > max_request_ - head_end) {
+        return fail(413);
+    }
+    if (data.size() < head_end + content_length) {
+        //头部已完整，只差正文：保留扫描位置，下次直接定位到头部末尾
+        scanned_ = head_end;
+        return Result::NeedMore;
+    }
+
+    request.body = data.substr(head_end, content_length);
+    request.keep_alive = keep_alive;
+    request.wire_size = head_end + content_length;
+    return Result::Complete;
+}
+
+const char* httpStatusReason(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        case 505: return "HTTP Version Not Supported";
+        default: return "Unknown";
+    }
+}
+
+size_t formatHttpResponseHead(char* out, size_t cap, int status, std::string_view content_type,
+                              size_t content_length, bool keep_alive) {
+    char* p = out;
+    char* end = out + cap;
+    auto put = [&p, end](std::string_view s) {
+        if (static_cast<size_t>(end - p) < s.size()) {
+            return false;
+        }
+        std::memcpy(p, s.data(), s.size());
+        p += s.size();
+        return true;
+    };
+    auto putNumber = [&p, end](size_t n) {
+        auto [ptr, ec] = std::to_chars(p, end, n);
+        if (ec != std::errc()) {
+            return false;
+        }
+        p = ptr;
+        return true;
+    };
+
+    bool ok = put("HTTP/1.1 ") && putNumber(static_cast<size_t>(status)) && put(" ") &&
+              put(httpStatusReason(status)) && put("\r\nContent-Type: ") && put(content_type) &&
+              put("\r\nContent-Length: ") && putNumber(content_length) &&
+              put(keep_alive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n");
+    return ok ? static_cast<size_t>(p - out) : 0;
+}
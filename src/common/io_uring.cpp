@@ -0,0 +1,322 @@
+#include "../../include/io_uring.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+//内核与用户态共享的环形队列指针需要按acquire/release语义读写
+static unsigned loadAcquire(unsigned* p) {
+    return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire);
+}
+
+static void storeRelease(unsigned* p, unsigned v) {
+    std::atomic_ref<unsigned>(*p).store(v, std::memory_order_release);
+}
+
+IoUring::IoUring()
+    : ring_fd_(-1), features_(0), sq_ptr_(MAP_FAILED), sq_size_(0), cq_ptr_(MAP_FAILED), cq_size_(0),
+      sqes_(nullptr), sqes_size_(0), sq_head_(nullptr), sq_tail_(nullptr), sq_mask_(nullptr),
+      sq_entries_(nullptr), sq_array_(nullptr), sqe_head_(0), sqe_tail_(0), cq_head_(nullptr),
+      cq_tail_(nullptr), cq_mask_(nullptr), cqes_(nullptr) {}
+
+IoUring::~IoUring() {
+    close();
+}
+
+bool IoUring::init(unsigned entries) {
+    if (ring_fd_ != -1) {
+        std::cerr << "IoUring already created" << std::endl;
+        return false;
+    }
+
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    //完成事件只在调用io_uring_enter时处理，减少内核对reactor线程的打断
+    //不使用SINGLE_ISSUER：环在主线程创建，却在reactor线程提交
+    params.flags = IORING_SETUP_COOP_TASKRUN;
+
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0 && errno == EINVAL) {
+        //较旧的内核不认识上述标志
+        std::memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    }
+    if (fd < 0) {
+        perror("io_uring_setup failed");
+        return false;
+    }
+    ring_fd_ = fd;
+    features_ = params.features;
+
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (features_ & IORING_FEAT_SINGLE_MMAP) {
+        sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+
+    sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+        perror("io_uring mmap sq failed");
+        close();
+        return false;
+    }
+
+    if (features_ & IORING_FEAT_SINGLE_MMAP) {
+        cq_ptr_ = sq_ptr_;
+    } else {
+        cq_ptr_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ptr_ == MAP_FAILED) {
+            perror("io_uring mmap cq failed");
+            close();
+            return false;
+        }
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        perror("io_uring mmap sqes failed");
+        close();
+        return false;
+    }
+    sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sq_ptr_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_entries_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    char* cq = static_cast<char*>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    sqe_head_ = sqe_tail_ = *sq_tail_;
+    return true;
+}
+
+void IoUring::close() {
+    if (sqes_ != nullptr) {
+        munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+    if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) {
+        munmap(cq_ptr_, cq_size_);
+    }
+    cq_ptr_ = MAP_FAILED;
+    if (sq_ptr_ != MAP_FAILED) {
+        munmap(sq_ptr_, sq_size_);
+        sq_ptr_ = MAP_FAILED;
+    }
+    if (ring_fd_ != -1) {
+        ::close(ring_fd_);
+        ring_fd_ = -1;
+    }
+}
+
+struct io_uring_sqe* IoUring::getSqe() {
+    if (ring_fd_ == -1) {
+        return nullptr;
+    }
+
+    if (sqe_tail_ - loadAcquire(sq_head_) >= *sq_entries_) {
+        submit();
+        if (sqe_tail_ - loadAcquire(sq_head_) >= *sq_entries_) {
+            return nullptr;
+        }
+    }
+
+    struct io_uring_sqe* sqe = &sqes_[sqe_tail_ & *sq_mask_];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe_tail_++;
+    return sqe;
+}
+
+//把新分配的SQE写入提交数组并发布tail，返回待提交的数量
+unsigned IoUring::flushSq() {
+    unsigned tail = *sq_tail_;
+    unsigned mask = *sq_mask_;
+    unsigned to_submit = sqe_tail_ - sqe_head_;
+    for (; sqe_head_ != sqe_tail_; sqe_head_++, tail++) {
+        sq_array_[tail & mask] = sqe_head_ & mask;
+    }
+    storeRelease(sq_tail_, tail);
+    return to_submit;
+}
+
+int IoUring::submitAndWait(unsigned wait_nr) {
+    if (ring_fd_ == -1) {
+        return -1;
+    }
+
+    unsigned to_submit = flushSq();
+    if (to_submit == 0 && wait_nr == 0) {
+        return 0;
+    }
+
+    unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    int ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, to_submit, wait_nr, flags, nullptr, 0));
+    if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        perror("io_uring_enter failed");
+    }
+    return ret;
+}
+
+unsigned IoUring::peekCqes(struct io_uring_cqe** cqes, unsigned max) {
+    unsigned head = *cq_head_;
+    unsigned ready = loadAcquire(cq_tail_) - head;
+    unsigned n = ready < max ? ready : max;
+    for (unsigned i = 0; i < n; i++) {
+        cqes[i] = &cqes_[(head + i) & *cq_mask_];
+    }
+    return n;
+}
+
+void IoUring::advance(unsigned n) {
+    if (n > 0) {
+        storeRelease(cq_head_, *cq_head_ + n);
+    }
+}
+
+void IoUring::prepareAccept(struct io_uring_sqe* sqe, int fd, bool multishot, uint64_t user_data) {
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    if (multishot) {
+        sqe->ioprio |= IORING_ACCEPT_MULTISHOT;
+    }
+    sqe->user_data = user_data;
+}
+
+//len为0且设置IOSQE_BUFFER_SELECT时，由内核从buffer_group对应的缓冲环中选取接收缓冲区
+void IoUring::prepareRecv(struct io_uring_sqe* sqe, int fd, uint16_t buffer_group, bool multishot, uint64_t user_data) {
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = buffer_group;
+    if (multishot) {
+        sqe->ioprio |= IORING_RECV_MULTISHOT;
+    }
+    sqe->user_data = user_data;
+}
+
+void IoUring::prepareSend(struct io_uring_sqe* sqe, int fd, const void* data, size_t len, uint64_t user_data) {
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = static_cast<uint32_t>(len);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = user_data;
+}
+
+void IoUring::prepareCancel(struct io_uring_sqe* sqe, uint64_t target, uint64_t user_data) {
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = target;
+    sqe->user_data = user_data;
+}
+
+void IoUring::prepareRead(struct io_uring_sqe* sqe, int fd, void* buf, size_t len, uint64_t user_data) {
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = static_cast<uint32_t>(len);
+    sqe->off = 0;
+    sqe->user_data = user_data;
+}
+
+ProvidedBufferRing::ProvidedBufferRing()
+    : ring_(nullptr), br_(nullptr), br_size_(0), buffers_(nullptr), count_(0), buffer_size_(0),
+      group_id_(0), tail_(0), pending_(0) {}
+
+ProvidedBufferRing::~ProvidedBufferRing() {
+    close();
+}
+
+bool ProvidedBufferRing::init(IoUring& ring, uint16_t group_id, unsigned count, size_t buffer_size) {
+    if (count == 0 || (count & (count - 1)) != 0 || count > 32768) {
+        std::cerr << "Invalid buffer ring size" << std::endl;
+        return false;
+    }
+
+    //环本身须按页对齐，mmap得到的内存天然满足
+    br_size_ = count * sizeof(struct io_uring_buf);
+    void* mem = mmap(nullptr, br_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("buffer ring mmap failed");
+        return false;
+    }
+    br_ = static_cast<struct io_uring_buf_ring*>(mem);
+
+    struct io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(br_);
+    reg.ring_entries = count;
+    reg.bgid = group_id;
+    if (syscall(__NR_io_uring_register, ring.getFd(), IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        perror("io_uring register buffer ring failed");
+        munmap(br_, br_size_);
+        br_ = nullptr;
+        return false;
+    }
+
+    ring_ = &ring;
+    count_ = count;
+    buffer_size_ = buffer_size;
+    group_id_ = group_id;
+    buffers_ = new char[count * buffer_size];
+    tail_ = 0;
+    pending_ = 0;
+
+    for (unsigned i = 0; i < count; i++) {
+        recycle(static_cast<uint16_t>(i));
+    }
+    commit();
+    return true;
+}
+
+void ProvidedBufferRing::close() {
+    if (br_ == nullptr) {
+        return;
+    }
+
+    if (ring_ != nullptr && ring_->isValid()) {
+        struct io_uring_buf_reg reg;
+        std::memset(&reg, 0, sizeof(reg));
+        reg.bgid = group_id_;
+        syscall(__NR_io_uring_register, ring_->getFd(), IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    }
+    munmap(br_, br_size_);
+    br_ = nullptr;
+    delete[] buffers_;
+    buffers_ = nullptr;
+}
+
+void ProvidedBufferRing::recycle(uint16_t bid) {
+    //不使用br_->bufs：内核头文件的__DECLARE_FLEX_ARRAY在C++下会包一层空结构体，使数组偏移8字节
+    struct io_uring_buf* bufs = reinterpret_cast<struct io_uring_buf*>(br_);
+    struct io_uring_buf* buf = &bufs[(tail_ + pending_) & (count_ - 1)];
+    buf->addr = reinterpret_cast<uint64_t>(buffer(bid));
+    buf->len = static_cast<uint32_t>(buffer_size_);
+    buf->bid = bid;
+    pending_++;
+}
+
+void ProvidedBufferRing::commit() {
+    if (pending_ == 0) {
+        return;
+    }
+    tail_ = static_cast<uint16_t>(tail_ + pending_);
+    pending_ = 0;
+    std::atomic_ref<uint16_t>(br_->tail).store(tail_, std::memory_order_release);
+}
@@ -0,0 +1,138 @@
+#include "../../include/metrics.h"
+
+#include <cstdio>
+
+namespace {
+
+void appendHeader(std::string& out, const std::string& name, const char* type, const char* help) {
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " " + type + "\n";
+}
+
+//按reactor逐个输出某个整数字段
+template <typename Field>
+void appendPerReactor(std::string& out, const std::string& name, const char* type, const char* help,
+                      const std::vector<LoopMetrics>& reactors, Field field) {
+    appendHeader(out, name, type, help);
+    for (size_t i = 0; i < reactors.size(); i++) {
+        out += name + "{reactor=\"" + std::to_string(i) + "\"} " + std::to_string(field(reactors[i])) + "\n";
+    }
+}
+
+template <typename Field>
+void appendSummary(std::string& out, const std::string& name, const char* help,
+                   const std::vector<LoopMetrics>& reactors, Field field) {
+    static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+    appendHeader(out, name, "summary", help);
+    for (size_t i = 0; i < reactors.size(); i++) {
+        const Histogram& h = field(reactors[i]);
+        std::string label = "reactor=\"" + std::to_string(i) + "\"";
+        for (double q : quantiles) {
+            char quantile[16];
+            std::snprintf(quantile, sizeof(quantile), "%g", q);
+            out += name + "{" + label + ",quantile=\"" + quantile + "\"} " +
+                   std::to_string(h.percentile(q * 100)) + "\n";
+        }
+        out += name + "_sum{" + label + "} " + std::to_string(h.sum()) + "\n";
+        out += name + "_count{" + label + "} " + std::to_string(h.count()) + "\n";
+    }
+}
+
+}
+
+std::string formatPrometheus(const std::vector<LoopMetrics>& reactors,
+                             const std::vector<std::pair<std::string, uint64_t>>& globals,
+                             const std::string& prefix) {
+    std::string out;
+    out.reserve(8192);
+    using M = const LoopMetrics&;
+
+    appendPerReactor(out, prefix + "_accepts_total", "counter", "Accepted connections", reactors,
+                     [](M m) { return m.accepts; });
+    appendPerReactor(out, prefix + "_accept_errors_total", "counter", "Failed accept calls", reactors,
+                     [](M m) { return m.accept_errors; });
+    appendPerReactor(out, prefix + "_closes_total", "counter", "Closed connections", reactors,
+                     [](M m) { return m.closes; });
+    appendPerReactor(out, prefix + "_bytes_in_total", "counter", "Bytes received", reactors,
+                     [](M m) { return m.bytes_in; });
+    appendPerReactor(out, prefix + "_bytes_out_total", "counter", "Bytes sent", reactors,
+                     [](M m) { return m.bytes_out; });
+    appendPerReactor(out, prefix + "_read_calls_total", "counter", "Read system calls", reactors,
+                     [](M m) { return m.read_calls; });
+    appendPerReactor(out, prefix + "_read_eagain_total", "counter", "Reads that returned EAGAIN", reactors,
+                     [](M m) { return m.read_eagain; });
+    appendPerReactor(out, prefix + "_write_calls_total", "counter", "Write system calls", reactors,
+                     [](M m) { return m.write_calls; });
+    appendPerReactor(out, prefix + "_write_eagain_total", "counter", "Writes that returned EAGAIN", reactors,
+                     [](M m) { return m.write_eagain; });
+    appendPerReactor(out, prefix + "_short_writes_total", "counter", "Writes that left data queued", reactors,
+                     [](M m) { return m.short_writes; });
+    appendPerReactor(out, prefix + "_wait_calls_total", "counter", "Event wait calls", reactors,
+                     [](M m) { return m.wait_calls; });
+    appendPerReactor(out, prefix + "_events_total", "counter", "Events returned by wait", reactors,
+                     [](M m) { return m.events; });
+    appendPerReactor(out, prefix + "_messages_total", "counter", "Framed messages handled", reactors,
+                     [](M m) { return m.messages; });
+    appendPerReactor(out, prefix + "_offloaded_total", "counter", "Messages handed to the worker pool", reactors,
+                     [](M m) { return m.offloaded; });
+    appendPerReactor(out, prefix + "_tasks_total", "counter", "Cross-thread tasks run", reactors,
+                     [](M m) { return m.tasks; });
+    appendPerReactor(out, prefix + "_upstream_connects_total", "counter", "Upstream connections used by the proxy",
+                     reactors, [](M m) { return m.upstream_connects; });
+    appendPerReactor(out, prefix + "_upstream_pool_hits_total", "counter", "Upstream connections taken pre-connected",
+                     reactors, [](M m) { return m.upstream_pool_hits; });
+    appendPerReactor(out, prefix + "_upstream_failures_total", "counter", "Failed or timed out upstream connects",
+                     reactors, [](M m) { return m.upstream_failures; });
+    appendPerReactor(out, prefix + "_proxied_bytes_total", "counter", "Bytes spliced between clients and upstreams",
+                     reactors, [](M m) { return m.proxied_bytes; });
+    appendPerReactor(out, prefix + "_published_total", "counter", "PUB commands received", reactors,
+                     [](M m) { return m.published; });
+    appendPerReactor(out, prefix + "_fanout_deliveries_total", "counter", "Messages queued to subscribers", reactors,
+                     [](M m) { return m.fanout_deliveries; });
+    appendPerReactor(out, prefix + "_fanout_drops_total", "counter", "Messages dropped for slow subscribers",
+                     reactors, [](M m) { return m.fanout_drops; });
+    appendPerReactor(out, prefix + "_slow_disconnects_total", "counter", "Subscribers disconnected for being slow",
+                     reactors, [](M m) { return m.slow_disconnects; });
+    appendPerReactor(out, prefix + "_cache_forwarded_total", "counter", "Cache commands forwarded to the owning shard",
+                     reactors, [](M m) { return m.cache_forwarded; });
+    appendPerReactor(out, prefix + "_cache_hits_total", "counter", "Cache GET hits", reactors,
+                     [](M m) { return m.cache_hits; });
+    appendPerReactor(out, prefix + "_cache_misses_total", "counter", "Cache GET misses", reactors,
+                     [](M m) { return m.cache_misses; });
+    appendPerReactor(out, prefix + "_cache_evictions_total", "counter", "Cache items evicted under the memory limit",
+                     reactors, [](M m) { return m.cache_evictions; });
+    appendPerReactor(out, prefix + "_cache_expirations_total", "counter", "Cache items removed after expiring",
+                     reactors, [](M m) { return m.cache_expirations; });
+
+    appendPerReactor(out, prefix + "_active_connections", "gauge", "Open connections", reactors,
+                     [](M m) { return m.active_connections; });
+    appendPerReactor(out, prefix + "_output_queue_bytes", "gauge", "Bytes waiting in send queues", reactors,
+                     [](M m) { return m.output_queue_bytes; });
+    appendPerReactor(out, prefix + "_deferred_messages", "gauge", "Messages waiting behind an offloaded one",
+                     reactors, [](M m) { return m.deferred_messages; });
+    appendPerReactor(out, prefix + "_paused_connections", "gauge", "Connections with reading paused", reactors,
+                     [](M m) { return m.paused_connections; });
+    appendPerReactor(out, prefix + "_subscriptions", "gauge", "Topic subscriptions", reactors,
+                     [](M m) { return m.subscriptions; });
+    appendPerReactor(out, prefix + "_cache_items", "gauge", "Items in the cache shard", reactors,
+                     [](M m) { return m.cache_items; });
+    appendPerReactor(out, prefix + "_cache_memory_bytes", "gauge", "Slab memory held by the cache shard", reactors,
+                     [](M m) { return m.cache_memory_bytes; });
+
+    appendSummary(out, prefix + "_events_per_wait", "Events returned per wait call", reactors,
+                  [](M m) -> const Histogram& { return m.events_per_wait; });
+    appendSummary(out, prefix + "_loop_duration_us", "Event loop iteration time excluding the wait", reactors,
+                  [](M m) -> const Histogram& { return m.loop_us; });
+    appendSummary(out, prefix + "_handler_duration_us", "Inline message handler time", reactors,
+                  [](M m) -> const Histogram& { return m.handler_us; });
+    appendSummary(out, prefix + "_offload_duration_us", "Worker pool round trip per offloaded message", reactors,
+                  [](M m) -> const Histogram& { return m.offload_us; });
+
+    for (const auto& gauge : globals) {
+        std::string name = prefix + "_" + gauge.first;
+        out += "# TYPE " + name + " gauge\n";
+        out += name + " " + std::to_string(gauge.second) + "\n";
+    }
+    return out;
+}
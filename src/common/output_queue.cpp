@@ -0,0 +1,214 @@
+#include "../../include/output_queue.h"
+#include "../../include/socket.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <utility>
+
+#include <unistd.h>
+
+OutputQueue::OutputQueue(BufferPool* pool) : pool_(pool), bytes_(0) {}
+
+OutputQueue::~OutputQueue() {
+    clear();
+}
+
+void OutputQueue::append(const char* data, size_t len) {
+    while (len > 0) {
+        if (segments_.empty() || segments_.back().kind != Kind::Memory || segments_.back().chunk.writable() == 0) {
+            segments_.emplace_back(pool_);
+            segments_.back().chunk.reserve();
+        }
+        size_t n = segments_.back().chunk.append(data, len);
+        data += n;
+        len -= n;
+        bytes_ += n;
+    }
+}
+
+void OutputQueue::append(RingBuffer&& buffer) {
+    size_t len = buffer.readable();
+    if (len == 0) {
+        return;
+    }
+
+    //小块数据合并进尾块，避免队列里堆积大量几乎为空的块
+    if (!segments_.empty() && segments_.back().kind == Kind::Memory &&
+        len <= segments_.back().chunk.writable() && len <= pool_->blockSize() / 4) {
+        segments_.back().chunk.append(buffer);
+        buffer.consume(len);
+    } else {
+        segments_.emplace_back(pool_);
+        segments_.back().chunk = std::move(buffer);
+    }
+    bytes_ += len;
+}
+
+void OutputQueue::appendFile(int fd, off_t offset, size_t len, bool owns_fd) {
+    if (len == 0) {
+        if (owns_fd) {
+            ::close(fd);
+        }
+        return;
+    }
+    segments_.emplace_back(pool_);
+    Segment& seg = segments_.back();
+    seg.kind = Kind::File;
+    seg.fd = fd;
+    seg.offset = offset;
+    seg.remaining = len;
+    seg.owns_fd = owns_fd;
+    bytes_ += len;
+}
+
+void OutputQueue::appendPipe(int fd, size_t len, bool owns_fd) {
+    if (len == 0) {
+        if (owns_fd) {
+            ::close(fd);
+        }
+        return;
+    }
+    segments_.emplace_back(pool_);
+    Segment& seg = segments_.back();
+    seg.kind = Kind::Pipe;
+    seg.fd = fd;
+    seg.remaining = len;
+    seg.owns_fd = owns_fd;
+    bytes_ += len;
+}
+
+void OutputQueue::appendShared(SharedBuffer buffer, size_t offset, size_t len) {
+    if (offset >= buffer.size()) {
+        return;
+    }
+    if (len == 0 || len > buffer.size() - offset) {
+        len = buffer.size() - offset;
+    }
+    segments_.emplace_back(pool_);
+    Segment& seg = segments_.back();
+    seg.kind = Kind::Shared;
+    seg.shared = std::move(buffer);
+    seg.offset = static_cast<off_t>(offset);
+    seg.remaining = len;
+    bytes_ += len;
+}
+
+ssize_t OutputQueue::flush(Socket& socket) {
+    ssize_t total = 0;
+    bool blocked = false;
+    while (!segments_.empty() && !blocked) {
+        ssize_t n = inMemory(segments_.front()) ? flushMemory(socket, blocked) : flushDescriptor(socket, blocked);
+        if (n < 0) {
+            return -1;
+        }
+        total += n;
+    }
+    return total;
+}
+
+//从队首起聚集连续的内存块与共享缓冲区，一次writev发出
+ssize_t OutputQueue::flushMemory(Socket& socket, bool& blocked) {
+    struct iovec iov[MAX_FLUSH_CHUNKS * 2];
+    size_t cnt = 0;
+    size_t pending = 0;
+    for (size_t i = 0; i < segments_.size() && i < MAX_FLUSH_CHUNKS; i++) {
+        const Segment& seg = segments_[i];
+        if (!inMemory(seg)) {
+            break;
+        }
+        if (seg.kind == Kind::Shared) {
+            iov[cnt].iov_base = const_cast<char*>(seg.shared.data()) + seg.offset;
+            iov[cnt].iov_len = seg.remaining;
+            pending += seg.remaining;
+            cnt++;
+            continue;
+        }
+        int segs = seg.chunk.readableSegments(iov + cnt);
+        for (int j = 0; j < segs; j++) {
+            pending += iov[cnt + j].iov_len;
+        }
+        cnt += static_cast<size_t>(segs);
+    }
+
+    ssize_t n = socket.sendv(std::span<const struct iovec>(iov, cnt));
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            blocked = true;
+            return 0;
+        }
+        return -1;
+    }
+
+    consume(static_cast<size_t>(n));
+    if (static_cast<size_t>(n) < pending) {
+        blocked = true;     //套接字缓冲区已满
+    }
+    return n;
+}
+
+//文件用sendfile、管道用splice发送队首区间，没发完时记下进度，等下一次可写
+ssize_t OutputQueue::flushDescriptor(Socket& socket, bool& blocked) {
+    Segment& front = segments_.front();
+    ssize_t n = front.kind == Kind::File ? socket.sendFile(front.fd, front.offset, front.remaining)
+                                         : socket.spliceFrom(front.fd, front.remaining);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            blocked = true;
+            return 0;
+        }
+        return -1;
+    }
+    if (n == 0) {
+        errno = EIO;    //文件被截断或管道写端已关闭，剩余数据永远发不出去
+        return -1;
+    }
+
+    bytes_ -= static_cast<size_t>(n);
+    front.remaining -= static_cast<size_t>(n);
+    if (front.remaining == 0) {
+        popFront();
+    } else {
+        blocked = true;
+    }
+    return n;
+}
+
+//按块依次消费已发送的字节，发完的块归还给池，发完的共享缓冲区释放引用
+void OutputQueue::consume(size_t n) {
+    bytes_ -= n;
+    while (n > 0 && !segments_.empty()) {
+        Segment& seg = segments_.front();
+        if (seg.kind == Kind::Shared) {
+            size_t len = std::min(n, seg.remaining);
+            seg.offset += static_cast<off_t>(len);
+            seg.remaining -= len;
+            n -= len;
+            if (seg.remaining == 0) {
+                popFront();
+            }
+            continue;
+        }
+        RingBuffer& front = seg.chunk;
+        size_t len = std::min(n, front.readable());
+        front.consume(len);
+        n -= len;
+        if (front.empty()) {
+            popFront();
+        }
+    }
+}
+
+void OutputQueue::popFront() {
+    Segment& front = segments_.front();
+    if (front.owns_fd && front.fd != -1) {
+        ::close(front.fd);
+    }
+    segments_.pop_front();
+}
+
+void OutputQueue::clear() {
+    while (!segments_.empty()) {
+        popFront();
+    }
+    bytes_ = 0;
+}
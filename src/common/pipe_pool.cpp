@@ -0,0 +1,56 @@
+#include "../../include/pipe_pool.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+PipePool::PipePool(size_t max_idle, int pipe_size) : max_idle_(max_idle), pipe_size_(pipe_size) {
+    idle_.reserve(max_idle_);
+}
+
+PipePool::~PipePool() {
+    for (Pipe& pipe : idle_) {
+        close(pipe);
+    }
+}
+
+bool PipePool::acquire(Pipe& pipe) {
+    if (!idle_.empty()) {
+        pipe = idle_.back();
+        idle_.pop_back();
+        return true;
+    }
+
+    int fds[2];
+    if (::pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+        return false;
+    }
+    pipe.read_fd = fds[0];
+    pipe.write_fd = fds[1];
+    pipe.buffered = 0;
+    //调整失败（超过/proc/sys/fs/pipe-max-size）时保持默认容量
+    if (pipe_size_ > 0) {
+        ::fcntl(pipe.write_fd, F_SETPIPE_SZ, pipe_size_);
+    }
+    int size = ::fcntl(pipe.write_fd, F_GETPIPE_SZ);
+    pipe.capacity = size > 0 ? static_cast<size_t>(size) : 65536;
+    created_++;
+    return true;
+}
+
+void PipePool::release(Pipe& pipe) {
+    if (!pipe.isOpen()) {
+        return;
+    }
+    if (pipe.buffered == 0 && idle_.size() < max_idle_) {
+        idle_.push_back(pipe);
+    } else {
+        close(pipe);
+    }
+    pipe = Pipe();
+}
+
+void PipePool::close(Pipe& pipe) {
+    ::close(pipe.read_fd);
+    ::close(pipe.write_fd);
+    pipe = Pipe();
+}
@@ -0,0 +1,24 @@
+#include "../../include/shared_buffer.h"
+
+#include <cstring>
+#include <new>
+
+SharedBuffer SharedBuffer::allocate(size_t size) {
+    SharedBuffer buffer;
+    void* memory = ::operator new(sizeof(Block) + size);
+    buffer.block_ = new (memory) Block{{1}, size};
+    return buffer;
+}
+
+SharedBuffer SharedBuffer::copyOf(std::string_view bytes) {
+    SharedBuffer buffer = allocate(bytes.size());
+    if (!bytes.empty()) {
+        std::memcpy(buffer.mutableData(), bytes.data(), bytes.size());
+    }
+    return buffer;
+}
+
+void SharedBuffer::destroy(Block* block) {
+    block->~Block();
+    ::operator delete(block);
+}
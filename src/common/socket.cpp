@@ -1,18 +1,31 @@
 #include "../../include/socket.h"
+#include "../../include/buffer.h"
+#include "../../include/datagram_batch.h"
+#include "../../include/socket_address.h"
 
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <poll.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <climits>
 #include <cstring>
 #include <stdexcept>
 #include <iostream>
 
 //初始化Socket类，标记为未连接状态
-Socket::Socket() : fd_(-1), is_non_blocking_(false) {}
+Socket::Socket() : fd_(-1), is_non_blocking_(false), type_(SocketType::Stream), family_(AF_UNSPEC) {}
+
+//接管一个已经打开的流式套接字（例如由io_uring accept得到的fd）
+Socket::Socket(int fd) : fd_(fd), is_non_blocking_(false), type_(SocketType::Stream), family_(AF_UNSPEC) {}
 
 //如果连接仍然存活，需要关闭连接后才能回收资源
 Socket::~Socket() {
@@ -22,7 +35,8 @@ Socket::~Socket() {
 }
 
 //移动构造，需要将构造的新连接设置为未连接状态
-Socket::Socket(Socket&& other) noexcept : fd_(other.fd_), is_non_blocking_(other.is_non_blocking_) {
+Socket::Socket(Socket&& other) noexcept
+    : fd_(other.fd_), is_non_blocking_(other.is_non_blocking_), type_(other.type_), family_(other.family_) {
     other.fd_ = -1;
 }
 
@@ -33,21 +47,32 @@ Socket& Socket::operator=(Socket&& other) noexcept {
         }
         fd_ = other.fd_;
         is_non_blocking_ = other.is_non_blocking_;
+        type_ = other.type_;
+        family_ = other.family_;
         other.fd_ = -1;
     }
     return *this;
 }
 
 //创建Socket套接字
-bool Socket::createSocket() {
-    //参数说明：domain - 协议簇(AF_INIT代表IPv4协议)
-    //type - 指定socket类型(SOCK_STREAM代表流式套接字)
+bool Socket::createSocket(SocketType type, int family) {
+    //参数说明：domain - 协议簇(AF_INET/AF_INET6为IP协议，AF_UNIX为本机进程间通信)
+    //type - 指定socket类型(SOCK_STREAM代表流式套接字，SOCK_DGRAM代表数据报套接字)
     //protocol - 指定协议类型，为0时自动匹配type支持的协议
-    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    fd_ = socket(family, type == SocketType::Stream ? SOCK_STREAM : SOCK_DGRAM, 0);
     if (fd_ == -1) {
+        int saved = errno;  //调用方据此判断是否退回IPv4
         std::cerr << "Socket creation failed" << std::endl;
+        errno = saved;
         return false;
     }
+    type_ = type;
+    family_ = family;
+
+    //Unix域套接字没有TIME_WAIT，地址复用由调用方在bind前删除旧的套接字文件
+    if (family == AF_UNIX) {
+        return true;
+    }
 
     int opt = 1;    //启用 SO_REUSEADDR 字段的标志位
     //setsockopt：设置套接字选项
@@ -60,33 +85,43 @@ bool Socket::createSocket() {
     return true;
 }
 
-//将套接字绑定至端口号
-/*
- * 说明：结构体sockaddr_in的构成如下：
- * struct sockaddr_in{
- *      sa_family_t     sin_family
- *      in_port_t       sin_port
- *      struct in_addr  sin_addr
- * };
- *
- * struct in_addr{
- *      uint32_t     s_addr
- * }
- */
+//将套接字绑定至端口号，IPv6套接字绑定到[::]
 bool Socket::bindSocket(int port) {
-    if (fd_ == -1) {
-        std::cerr << "Socket bind failed" << std::endl;
+    return bindSocket(family_ == AF_INET6 ? SocketAddress::any(port) : SocketAddress::ipv4Any(port));
+}
+
+bool Socket::bindSocket(const std::string& host, int port) {
+    if (host.empty() || host == "*") {
+        return bindSocket(port);
+    }
+
+    SocketAddress address;
+    if (!SocketAddress::resolve(host, port, address)) {
         return false;
     }
+    return bindSocket(address);
+}
 
-    struct sockaddr_in address;
-    std::memset(&address, 0, sizeof(address));  //声明后初始化为0，避免读取到垃圾值
+bool Socket::bindSocket(const SocketAddress& address) {
+    if (fd_ == -1 || !address.isValid()) {
+        std::cerr << "Socket bind failed" << std::endl;
+        return false;
+    }
+    if (address.family() != family_) {
+        std::cerr << "Socket bind failed: address family mismatch for " << address.toString() << std::endl;
+        return false;
+    }
 
-    address.sin_family = AF_INET;
-    address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(port); //htons将端口号转为大端序（高位在前）
+    //双栈：IPv4客户端以::ffff:a.b.c.d的映射地址出现在同一个监听套接字上
+    if (family_ == AF_INET6 && address.isWildcard()) {
+        int off = 0;
+        if (setsockopt(fd_, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off)) < 0) {
+            perror("setsockopt IPV6_V6ONLY failed");
+            return false;
+        }
+    }
 
-    if (::bind(fd_, (struct sockaddr*)&address, sizeof(address)) < 0) {
+    if (::bind(fd_, address.get(), address.length()) < 0) {
         perror("bind failed");
         return false;
     }
@@ -116,7 +151,7 @@ Socket Socket::acceptSocket() {
         throw std::runtime_error("Socket accept failed");
     }
 
-    struct sockaddr_in client_addr;
+    struct sockaddr_storage client_addr;
     socklen_t client_addr_len = sizeof(client_addr);
 
     //以阻塞方式等待客户端连接
@@ -135,35 +170,131 @@ Socket Socket::acceptSocket() {
     Socket client_socket;
     client_socket.fd_ = client_fd;
     client_socket.is_non_blocking_ = is_non_blocking_;
+    client_socket.type_ = type_;
+    client_socket.family_ = family_;
 
     return client_socket;
 }
 
+Socket Socket::acceptNonBlocking(SocketAddress& peer) {
+    peer.length() = SocketAddress::capacity();
+    int client_fd = ::accept4(fd_, peer.get(), &peer.length(), SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (client_fd < 0) {
+        peer.length() = 0;
+        return Socket();
+    }
+
+    Socket client_socket;
+    client_socket.fd_ = client_fd;
+    client_socket.is_non_blocking_ = true;
+    client_socket.type_ = type_;
+    client_socket.family_ = family_;
+    return client_socket;
+}
+
 //建立连接
 bool Socket::connect(const std::string& ip, int port) {
-    if (fd_ == -1) {
+    SocketAddress address;
+    if (!SocketAddress::resolve(ip, port, address)) {
+        return false;
+    }
+    return connect(address);
+}
+
+bool Socket::connect(const SocketAddress& address) {
+    if (fd_ == -1 || !address.isValid()) {
         std::cerr << "Socket connect failed" << std::endl;
         return false;
     }
 
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
+    //调用方按默认的AF_INET创建了套接字但目标是IPv6或Unix地址：换成对应地址族的新套接字
+    if (address.family() != family_) {
+        bool non_blocking = is_non_blocking_;
+        close();
+        if (!createSocket(type_, address.family()) || (non_blocking && !setNonBlocking())) {
+            return false;
+        }
+    }
+
+    if (::connect(fd_, address.get(), address.length()) < 0) {
+        perror("connect failed");
+        return false;
+    }
+
+    return true;
+}
 
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
+bool Socket::connectNonBlocking(const SocketAddress& address) {
+    if (!address.isValid()) {
+        errno = EINVAL;
+        return false;
+    }
+    close();
+    fd_ = ::socket(address.family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_ == -1) {
+        return false;
+    }
+    is_non_blocking_ = true;
+    type_ = SocketType::Stream;
+    family_ = address.family();
 
-    //将文本地址转为二进制地址，并复制到server_addr结构体
-    if (inet_pton(AF_INET, ip.c_str(), &server_addr.sin_addr) <= 0) {
-        perror("inet_pton failed");
+    //Unix域套接字通常立即连上；TCP返回EINPROGRESS，结果随可写通知到达
+    if (::connect(fd_, address.get(), address.length()) < 0 && errno != EINPROGRESS) {
+        int saved = errno;
+        close();
+        errno = saved;
         return false;
     }
+    return true;
+}
 
-    if (::connect(fd_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+bool Socket::connect(const SocketAddress& address, int timeout_ms) {
+    if (!connectNonBlocking(address)) {
         perror("connect failed");
         return false;
     }
 
-    return true;
+    int error = finishConnect();
+    if (error == EINPROGRESS) {
+        struct pollfd pfd = {fd_, POLLOUT, 0};
+        int n;
+        do {
+            n = ::poll(&pfd, 1, timeout_ms);
+        } while (n < 0 && errno == EINTR);
+        error = n == 0 ? ETIMEDOUT : (n < 0 ? errno : finishConnect());
+    }
+    if (error != 0) {
+        close();
+        std::cerr << "connect failed: " << std::strerror(error) << std::endl;
+        errno = error;
+        return false;
+    }
+    return setNonBlocking(false);
+}
+
+//SO_ERROR为0只说明还没有失败，再用getpeername区分已连接与仍在握手
+int Socket::finishConnect() {
+    if (fd_ == -1) {
+        return EBADF;
+    }
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &len) < 0) {
+        return errno;
+    }
+    if (error != 0) {
+        return error;
+    }
+    struct sockaddr_storage peer;
+    socklen_t peer_len = sizeof(peer);
+    if (getpeername(fd_, reinterpret_cast<struct sockaddr*>(&peer), &peer_len) < 0) {
+        return errno == ENOTCONN ? EINPROGRESS : errno;
+    }
+    return 0;
+}
+
+bool Socket::shutdownWrite() {
+    return fd_ != -1 && ::shutdown(fd_, SHUT_WR) == 0;
 }
 
 //发送和接收数据
@@ -177,7 +308,12 @@ ssize_t Socket::send(const std::vector<char>& data) {
 }
 
 ssize_t Socket::send(const std::string& data) {
-    return send(std::vector<char>(data.begin(), data.end()));
+    if (fd_ == -1) {
+        std::cerr << "Socket send failed" << std::endl;
+        return -1;
+    }
+
+    return ::send(fd_, data.data(), data.size(), 0);
 }
 
 ssize_t Socket::recv(std::vector<char>& buffer, size_t size) {
@@ -205,6 +341,153 @@ ssize_t Socket::recv(std::vector<char>& buffer, size_t size) {
     return bytes_recv;
 }
 
+//聚集写：例如报文头与多段负载无需先拼接到同一块内存
+ssize_t Socket::sendv(std::span<const struct iovec> iov) {
+    if (fd_ == -1) {
+        std::cerr << "Socket send failed" << std::endl;
+        return -1;
+    }
+    if (iov.empty()) {
+        return 0;
+    }
+
+    int cnt = static_cast<int>(std::min<size_t>(iov.size(), IOV_MAX));
+    return ::writev(fd_, iov.data(), cnt);
+}
+
+ssize_t Socket::sendFile(int file_fd, off_t& offset, size_t count) {
+    if (fd_ == -1) {
+        std::cerr << "Socket send failed" << std::endl;
+        return -1;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    return ::sendfile(fd_, file_fd, &offset, count);
+}
+
+ssize_t Socket::spliceFrom(int pipe_fd, size_t count) {
+    if (fd_ == -1) {
+        std::cerr << "Socket send failed" << std::endl;
+        return -1;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    return ::splice(pipe_fd, nullptr, fd_, nullptr, count, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+}
+
+ssize_t Socket::spliceTo(int pipe_fd, size_t count) {
+    if (fd_ == -1) {
+        std::cerr << "Socket recv failed" << std::endl;
+        return -1;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    return ::splice(fd_, nullptr, pipe_fd, nullptr, count, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+}
+
+ssize_t Socket::recvv(std::span<const struct iovec> iov) {
+    if (fd_ == -1) {
+        std::cerr << "Socket recv failed" << std::endl;
+        return -1;
+    }
+    if (iov.empty()) {
+        return 0;
+    }
+
+    int cnt = static_cast<int>(std::min<size_t>(iov.size(), IOV_MAX));
+    ssize_t bytes_recv = ::readv(fd_, iov.data(), cnt);
+    if (bytes_recv < 0 && (!is_non_blocking_ || (errno != EAGAIN && errno != EWOULDBLOCK))) {
+        perror("recv failed");
+    }
+    return bytes_recv;
+}
+
+std::span<struct iovec> Socket::advance(std::span<struct iovec> iov, size_t n) {
+    size_t i = 0;
+    while (i < iov.size() && n >= iov[i].iov_len) {
+        n -= iov[i].iov_len;
+        i++;
+    }
+    if (i < iov.size() && n > 0) {
+        iov[i].iov_base = static_cast<char*>(iov[i].iov_base) + n;
+        iov[i].iov_len -= n;
+    }
+    return iov.subspan(i);
+}
+
+//readv一次填满环形缓冲区的两段可写区域，数据从内核直接拷入连接缓冲区
+ssize_t Socket::recv(RingBuffer& buffer) {
+    struct iovec iov[2];
+    int cnt = buffer.writableSegments(iov);
+    if (cnt == 0) {
+        errno = ENOBUFS;
+        return -1;
+    }
+
+    ssize_t bytes_recv = recvv(std::span<const struct iovec>(iov, cnt));
+    if (bytes_recv > 0) {
+        buffer.produce(static_cast<size_t>(bytes_recv));
+    }
+    return bytes_recv;
+}
+
+ssize_t Socket::send(RingBuffer& buffer) {
+    struct iovec iov[2];
+    int cnt = buffer.readableSegments(iov);
+    if (cnt == 0) {
+        return 0;
+    }
+
+    ssize_t bytes_sent = sendv(std::span<const struct iovec>(iov, cnt));
+    if (bytes_sent > 0) {
+        buffer.consume(static_cast<size_t>(bytes_sent));
+    }
+    return bytes_sent;
+}
+
+//一次系统调用收取最多capacity个数据报，每个数据报的长度与来源地址记录在batch中
+int Socket::recvBatch(DatagramBatch& batch) {
+    if (fd_ == -1) {
+        std::cerr << "Socket recvBatch failed" << std::endl;
+        return -1;
+    }
+
+    batch.prepareReceive();
+    int n = ::recvmmsg(fd_, batch.headers(), static_cast<unsigned int>(batch.capacity()), 0, nullptr);
+    if (n < 0) {
+        if (!is_non_blocking_ || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            perror("recvmmsg failed");
+        }
+        return -1;
+    }
+
+    batch.setCount(static_cast<size_t>(n));
+    return n;
+}
+
+//sendmmsg可能只发出一部分（发送缓冲区满），返回值为实际发出的个数
+int Socket::sendBatch(DatagramBatch& batch) {
+    if (fd_ == -1) {
+        std::cerr << "Socket sendBatch failed" << std::endl;
+        return -1;
+    }
+    if (batch.empty()) {
+        return 0;
+    }
+
+    int n = ::sendmmsg(fd_, batch.headers(), static_cast<unsigned int>(batch.size()), 0);
+    if (n < 0 && (!is_non_blocking_ || (errno != EAGAIN && errno != EWOULDBLOCK))) {
+        perror("sendmmsg failed");
+    }
+    return n;
+}
+
 bool Socket::setNonBlocking(bool nonblock) {
     if (fd_ == -1) {
         std::cerr << "Socket setNonBlocking failed" << std::endl;
@@ -232,6 +515,64 @@ bool Socket::setNonBlocking(bool nonblock) {
     return true;
 }
 
+//SO_REUSEPORT：允许多个套接字绑定同一端口，由内核在它们之间分发新连接
+//多reactor模式下每个线程各自持有一个监听套接字，需在bind之前设置
+bool Socket::setReusePort(bool enable) {
+    if (fd_ == -1) {
+        std::cerr << "Socket setReusePort failed" << std::endl;
+        return false;
+    }
+
+    int opt = enable ? 1 : 0;
+    if (setsockopt(fd_, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        perror("setsockopt SO_REUSEPORT failed");
+        return false;
+    }
+
+    return true;
+}
+
+//各个套接字选项的设置方式相同，失败时打印选项名
+static bool setIntOption(int fd, int level, int name, int value, const char* what) {
+    if (fd == -1) {
+        std::cerr << "Socket " << what << " failed" << std::endl;
+        return false;
+    }
+    if (setsockopt(fd, level, name, &value, sizeof(value)) < 0) {
+        std::cerr << "setsockopt " << what << " failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Socket::setNoDelay(bool enable) {
+    return setIntOption(fd_, IPPROTO_TCP, TCP_NODELAY, enable ? 1 : 0, "TCP_NODELAY");
+}
+
+bool Socket::setSendBufferSize(int bytes) {
+    return setIntOption(fd_, SOL_SOCKET, SO_SNDBUF, bytes, "SO_SNDBUF");
+}
+
+bool Socket::setReceiveBufferSize(int bytes) {
+    return setIntOption(fd_, SOL_SOCKET, SO_RCVBUF, bytes, "SO_RCVBUF");
+}
+
+bool Socket::setDeferAccept(int seconds) {
+    return setIntOption(fd_, IPPROTO_TCP, TCP_DEFER_ACCEPT, seconds, "TCP_DEFER_ACCEPT");
+}
+
+bool Socket::setFastOpen(int queue_len) {
+    return setIntOption(fd_, IPPROTO_TCP, TCP_FASTOPEN, queue_len, "TCP_FASTOPEN");
+}
+
+bool Socket::setBusyPoll(int usec) {
+    return setIntOption(fd_, SOL_SOCKET, SO_BUSY_POLL, usec, "SO_BUSY_POLL");
+}
+
+bool Socket::setIncomingCpu(int cpu) {
+    return setIntOption(fd_, SOL_SOCKET, SO_INCOMING_CPU, cpu, "SO_INCOMING_CPU");
+}
+
 void Socket::close() {
     if (fd_ != -1) {
         ::close(fd_);
@@ -240,31 +581,23 @@ void Socket::close() {
     }
 }
 
-std::string Socket::getPeerAddress() const {
-    if (fd_ == -1) { return ""; }
-
-    struct sockaddr_in addr;
-    socklen_t len = sizeof(addr);
+bool Socket::getPeerName(SocketAddress& peer) const {
+    if (fd_ == -1) { return false; }
 
-    if (getpeername(fd_, (struct sockaddr*)&addr, &len) < 0) {
-        return "";
+    peer.length() = SocketAddress::capacity();
+    if (getpeername(fd_, peer.get(), &peer.length()) < 0) {
+        peer.length() = 0;
+        return false;
     }
+    return true;
+}
 
-    char ip_str[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &addr.sin_addr, ip_str, INET_ADDRSTRLEN);
-
-    return std::string(ip_str);
+std::string Socket::getPeerAddress() const {
+    SocketAddress peer;
+    return getPeerName(peer) ? peer.host() : "";
 }
 
 int Socket::getPeerPort() const {
-    if (fd_ == -1) { return -1; }
-
-    struct sockaddr_in addr;
-    socklen_t len = sizeof(addr);
-
-    if (getpeername(fd_, (struct sockaddr*)&addr, &len) < 0) {
-        return -1;
-    }
-
-    return ntohs(addr.sin_port);
+    SocketAddress peer;
+    return getPeerName(peer) ? peer.port() : -1;
 }
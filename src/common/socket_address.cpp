@@ -0,0 +1,223 @@
+#include "../../include/socket_address.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/un.h>
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+bool parsePort(std::string_view text, int& port) {
+    const char* end = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), end, port);
+    return ec == std::errc() && ptr == end && !text.empty() && port >= 0 && port <= 65535;
+}
+
+}
+
+SocketAddress::SocketAddress() : length_(0) {
+    std::memset(&storage_, 0, sizeof(storage_));
+}
+
+SocketAddress SocketAddress::any(int port) {
+    SocketAddress addr;
+    auto* in6 = reinterpret_cast<struct sockaddr_in6*>(&addr.storage_);
+    in6->sin6_family = AF_INET6;
+    in6->sin6_addr = in6addr_any;
+    in6->sin6_port = htons(static_cast<uint16_t>(port));
+    addr.length_ = sizeof(struct sockaddr_in6);
+    return addr;
+}
+
+SocketAddress SocketAddress::ipv4Any(int port) {
+    SocketAddress addr;
+    auto* in = reinterpret_cast<struct sockaddr_in*>(&addr.storage_);
+    in->sin_family = AF_INET;
+    in->sin_addr.s_addr = htonl(INADDR_ANY);
+    in->sin_port = htons(static_cast<uint16_t>(port));
+    addr.length_ = sizeof(struct sockaddr_in);
+    return addr;
+}
+
+bool SocketAddress::parse(std::string_view text, SocketAddress& out) {
+    if (text.substr(0, 5) == "unix:" || (!text.empty() && text.front() == '/')) {
+        std::string_view path = text.front() == '/' ? text : text.substr(5);
+        SocketAddress addr;
+        auto* un = reinterpret_cast<struct sockaddr_un*>(&addr.storage_);
+        if (path.empty() || path.size() >= sizeof(un->sun_path)) {
+            std::cerr << "Invalid unix socket path: " << text << std::endl;
+            return false;
+        }
+        un->sun_family = AF_UNIX;
+        std::memcpy(un->sun_path, path.data(), path.size());
+        //抽象命名空间：首字节为0，长度按实际名字计算，不含结尾的0
+        if (path.front() == '@') {
+            un->sun_path[0] = '\0';
+            addr.length_ = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + path.size());
+        } else {
+            addr.length_ = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + path.size() + 1);
+        }
+        out = addr;
+        return true;
+    }
+
+    std::string_view host;
+    std::string_view port_text = text;
+    if (!text.empty() && text.front() == '[') {
+        size_t close = text.find(']');
+        if (close == std::string_view::npos || close + 1 >= text.size() || text[close + 1] != ':') {
+            std::cerr << "Invalid address: " << text << std::endl;
+            return false;
+        }
+        host = text.substr(1, close - 1);
+        port_text = text.substr(close + 2);
+    } else {
+        size_t colon = text.rfind(':');
+        if (colon != std::string_view::npos) {
+            host = text.substr(0, colon);
+            port_text = text.substr(colon + 1);
+        }
+    }
+
+    int port = 0;
+    if (!parsePort(port_text, port)) {
+        std::cerr << "Invalid port in address: " << text << std::endl;
+        return false;
+    }
+    return resolve(std::string(host), port, out);
+}
+
+bool SocketAddress::resolve(const std::string& host, int port, SocketAddress& out) {
+    if (host.empty() || host == "*") {
+        out = any(port);
+        return true;
+    }
+    if (host.compare(0, 5, "unix:") == 0 || host.front() == '/') {
+        return parse(host, out);
+    }
+
+    SocketAddress addr;
+    auto* in = reinterpret_cast<struct sockaddr_in*>(&addr.storage_);
+    if (inet_pton(AF_INET, host.c_str(), &in->sin_addr) == 1) {
+        in->sin_family = AF_INET;
+        in->sin_port = htons(static_cast<uint16_t>(port));
+        addr.length_ = sizeof(struct sockaddr_in);
+        out = addr;
+        return true;
+    }
+    auto* in6 = reinterpret_cast<struct sockaddr_in6*>(&addr.storage_);
+    if (inet_pton(AF_INET6, host.c_str(), &in6->sin6_addr) == 1) {
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port = htons(static_cast<uint16_t>(port));
+        addr.length_ = sizeof(struct sockaddr_in6);
+        out = addr;
+        return true;
+    }
+
+    //主机名：取第一个结果
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    int rc = getaddrinfo(host.c_str(), nullptr, &hints, &result);
+    if (rc != 0 || result == nullptr) {
+        std::cerr << "Cannot resolve " << host << ": " << gai_strerror(rc) << std::endl;
+        return false;
+    }
+    std::memcpy(&addr.storage_, result->ai_addr, result->ai_addrlen);
+    addr.length_ = result->ai_addrlen;
+    freeaddrinfo(result);
+    if (addr.family() == AF_INET) {
+        in->sin_port = htons(static_cast<uint16_t>(port));
+    } else {
+        in6->sin6_port = htons(static_cast<uint16_t>(port));
+    }
+    out = addr;
+    return true;
+}
+
+bool SocketAddress::isWildcard() const {
+    if (family() == AF_INET) {
+        return reinterpret_cast<const struct sockaddr_in*>(&storage_)->sin_addr.s_addr == htonl(INADDR_ANY);
+    }
+    if (family() == AF_INET6) {
+        const auto* in6 = reinterpret_cast<const struct sockaddr_in6*>(&storage_);
+        return std::memcmp(&in6->sin6_addr, &in6addr_any, sizeof(in6addr_any)) == 0;
+    }
+    return false;
+}
+
+std::string SocketAddress::host() const {
+    char text[INET6_ADDRSTRLEN];
+    if (family() == AF_INET) {
+        inet_ntop(AF_INET, &reinterpret_cast<const struct sockaddr_in*>(&storage_)->sin_addr, text, sizeof(text));
+        return text;
+    }
+    if (family() == AF_INET6) {
+        const auto* in6 = reinterpret_cast<const struct sockaddr_in6*>(&storage_);
+        //双栈套接字上的IPv4对端显示为普通的IPv4地址
+        if (IN6_IS_ADDR_V4MAPPED(&in6->sin6_addr)) {
+            inet_ntop(AF_INET, &in6->sin6_addr.s6_addr[12], text, sizeof(text));
+        } else {
+            inet_ntop(AF_INET6, &in6->sin6_addr, text, sizeof(text));
+        }
+        return text;
+    }
+    if (family() == AF_UNIX) {
+        const auto* un = reinterpret_cast<const struct sockaddr_un*>(&storage_);
+        size_t offset = offsetof(struct sockaddr_un, sun_path);
+        if (length_ <= offset) {
+            return "";
+        }
+        size_t len = length_ - offset;
+        if (un->sun_path[0] == '\0') {
+            std::string name(1, '@');
+            name.append(un->sun_path + 1, len - 1);
+            return name;
+        }
+        return std::string(un->sun_path, strnlen(un->sun_path, len));
+    }
+    return "";
+}
+
+int SocketAddress::port() const {
+    if (family() == AF_INET) {
+        return ntohs(reinterpret_cast<const struct sockaddr_in*>(&storage_)->sin_port);
+    }
+    if (family() == AF_INET6) {
+        return ntohs(reinterpret_cast<const struct sockaddr_in6*>(&storage_)->sin6_port);
+    }
+    return 0;
+}
+
+std::string SocketAddress::toString() const {
+    if (family() == AF_UNIX) {
+        return "unix:" + host();
+    }
+    if (family() == AF_INET6) {
+        std::string h = host();
+        //映射的IPv4地址按IPv4格式显示
+        if (h.find(':') == std::string::npos) {
+            return h + ":" + std::to_string(port());
+        }
+        return "[" + h + "]:" + std::to_string(port());
+    }
+    if (family() == AF_INET) {
+        return host() + ":" + std::to_string(port());
+    }
+    return "";
+}
+
+std::string SocketAddress::unixPath() const {
+    if (family() != AF_UNIX) {
+        return "";
+    }
+    std::string path = host();
+    return !path.empty() && path.front() == '@' ? "" : path;
+}
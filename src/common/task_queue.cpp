@@ -0,0 +1,113 @@
+#include "../../include/task_queue.h"
+
+#include <cerrno>
+#include <cstdio>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+TaskQueue::TaskQueue() : event_fd_(-1), signaled_(false), head_(&stub_), tail_(&stub_), executed_(0) {}
+
+TaskQueue::~TaskQueue() {
+    close();
+    Node* node;
+    while ((node = pop()) != nullptr) {
+        delete node;
+    }
+}
+
+bool TaskQueue::open() {
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) {
+        perror("eventfd failed");
+        return false;
+    }
+    event_fd_.store(fd, std::memory_order_release);
+    return true;
+}
+
+void TaskQueue::close() {
+    int fd = event_fd_.exchange(-1);
+    if (fd != -1) {
+        ::close(fd);
+    }
+}
+
+bool TaskQueue::post(Task task) {
+    if (event_fd_.load(std::memory_order_acquire) == -1) {
+        return false;
+    }
+    Node* node = new Node;
+    node->task = std::move(task);
+    push(node);
+
+    //只有从"未通知"变为"已通知"的那次投递才写eventfd，其余投递合并到同一次唤醒中
+    if (!signaled_.exchange(true, std::memory_order_acq_rel)) {
+        uint64_t one = 1;
+        int fd = event_fd_.load(std::memory_order_acquire);
+        if (fd != -1 && ::write(fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            perror("eventfd write failed");
+        }
+    }
+    return true;
+}
+
+//先清除通知标志再取任务：清除之后的投递一定会重新写eventfd，不会丢失唤醒
+size_t TaskQueue::runPending() {
+    signaled_.store(false, std::memory_order_seq_cst);
+
+    size_t count = 0;
+    Node* node;
+    while ((node = pop()) != nullptr) {
+        node->task();
+        delete node;
+        count++;
+    }
+    executed_ += count;
+    return count;
+}
+
+void TaskQueue::handleEvent(uint32_t) {
+    uint64_t value;
+    while (::read(event_fd_.load(std::memory_order_relaxed), &value, sizeof(value)) > 0) {
+    }
+    runPending();
+}
+
+void TaskQueue::push(Node* node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+//某个生产者交换了head_但还没链接next时返回nullptr；它随后写eventfd，循环会再来取
+TaskQueue::Node* TaskQueue::pop() {
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &stub_) {
+        if (next == nullptr) {
+            return nullptr;
+        }
+        tail_ = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next != nullptr) {
+        tail_ = next;
+        return tail;
+    }
+
+    if (tail != head_.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    push(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+        tail_ = next;
+        return tail;
+    }
+    return nullptr;
+}
@@ -0,0 +1,126 @@
+#include "../../include/thread_pool.h"
+
+#include <cstdint>
+
+namespace {
+
+//当前线程所属的线程池及其队列下标，工作线程内部提交任务时直接放入自己的队列
+thread_local const ThreadPool* local_pool = nullptr;
+thread_local size_t local_index = 0;
+
+}
+
+ThreadPool::ThreadPool(size_t thread_count)
+    : next_queue_(0), pending_(0), sleepers_(0), running_(false), wake_seq_(0) {
+    size_t count = thread_count > 0 ? thread_count : 1;
+    for (size_t i = 0; i < count; i++) {
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+bool ThreadPool::start() {
+    if (running_.exchange(true)) {
+        return true;
+    }
+    for (size_t i = 0; i < queues_.size(); i++) {
+        threads_.emplace_back([this, i] { workerLoop(i); });
+    }
+    return true;
+}
+
+void ThreadPool::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    wake_seq_.fetch_add(1);
+    wake_seq_.notify_all();
+    for (auto& t : threads_) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+    threads_.clear();
+
+    for (auto& queue : queues_) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->tasks.clear();
+    }
+    pending_ = 0;
+}
+
+void ThreadPool::submit(Task task) {
+    size_t index = local_pool == this ? local_index
+                                      : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+
+    //与workerLoop中"sleepers_++后再检查pending_"配对：两边都用seq_cst，不会双方都看不到对方
+    pending_.fetch_add(1);
+    if (sleepers_.load() > 0) {
+        wake_seq_.fetch_add(1);
+        wake_seq_.notify_one();
+    }
+}
+
+//取出任务与递减计数之间有短暂的窗口，计数可能暂时回绕，此时按0处理
+size_t ThreadPool::pending() const {
+    size_t n = pending_.load(std::memory_order_relaxed);
+    return n > (SIZE_MAX >> 1) ? 0 : n;
+}
+
+bool ThreadPool::popLocal(size_t index, Task& task) {
+    WorkQueue& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    return true;
+}
+
+//从下一个队列开始依次尝试，从队尾偷，与队列主人的取出端错开
+bool ThreadPool::steal(size_t thief, Task& task) {
+    for (size_t i = 1; i < queues_.size(); i++) {
+        WorkQueue& queue = *queues_[(thief + i) % queues_.size()];
+        std::unique_lock<std::mutex> lock(queue.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || queue.tasks.empty()) {
+            continue;
+        }
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    local_pool = this;
+    local_index = index;
+
+    Task task;
+    while (running_.load(std::memory_order_acquire)) {
+        if (popLocal(index, task) || steal(index, task)) {
+            pending_.fetch_sub(1);
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        //try_lock偷取可能错过任务，pending_不为0时继续尝试而不是睡眠
+        sleepers_.fetch_add(1);
+        uint32_t seq = wake_seq_.load();
+        if (pending_.load() == 0 && running_.load()) {
+            wake_seq_.wait(seq);
+        }
+        sleepers_.fetch_sub(1);
+    }
+
+    local_pool = nullptr;
+}
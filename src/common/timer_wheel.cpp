@@ -0,0 +1,169 @@
+#include "../../include/timer_wheel.h"
+
+#include <chrono>
+
+TimerNode::~TimerNode() {
+    if (wheel_ != nullptr) {
+        wheel_->cancel(*this);
+    }
+}
+
+TimerWheel::TimerWheel(uint64_t tick_ms, uint64_t now_ms)
+    : tick_ms_(tick_ms > 0 ? tick_ms : 1), start_ms_(now_ms), current_(0), size_(0) {
+    for (int l = 0; l < LEVELS; l++) {
+        occupied_[l] = 0;
+        for (int s = 0; s < SLOTS; s++) {
+            slots_[l][s] = nullptr;
+        }
+    }
+}
+
+TimerWheel::~TimerWheel() {
+    for (int l = 0; l < LEVELS; l++) {
+        for (int s = 0; s < SLOTS; s++) {
+            while (slots_[l][s] != nullptr) {
+                unlink(*slots_[l][s]);
+            }
+        }
+    }
+}
+
+uint64_t TimerWheel::nowMs() {
+    using namespace std::chrono;
+    return static_cast<uint64_t>(duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+void TimerWheel::schedule(TimerNode& node, uint64_t delay_ms) {
+    if (node.wheel_ != nullptr) {
+        node.wheel_->unlink(node);
+    }
+
+    //向上取整且至少一个tick，保证不会落在正在处理的槽里
+    uint64_t ticks = (delay_ms + tick_ms_ - 1) / tick_ms_;
+    node.expire_ = current_ + (ticks > 0 ? ticks : 1);
+    link(node);
+}
+
+void TimerWheel::cancel(TimerNode& node) {
+    if (node.wheel_ == this) {
+        unlink(node);
+    }
+}
+
+//按剩余tick数选择层：剩余不足64^(l+1)个tick的放在第l层，超出范围的放在最高层的最远槽
+void TimerWheel::link(TimerNode& node) {
+    uint64_t delta = node.expire_ - current_;
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (static_cast<uint64_t>(1) << (SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+
+    uint64_t max_delta = static_cast<uint64_t>(1) << (SLOT_BITS * LEVELS);
+    if (delta >= max_delta) {
+        node.expire_ = current_ + max_delta - 1;
+    }
+
+    int slot = static_cast<int>((node.expire_ >> (SLOT_BITS * level)) & SLOT_MASK);
+    node.level_ = static_cast<uint8_t>(level);
+    node.slot_ = static_cast<uint8_t>(slot);
+    node.wheel_ = this;
+    node.prev_ = nullptr;
+    node.next_ = slots_[level][slot];
+    if (node.next_ != nullptr) {
+        node.next_->prev_ = &node;
+    }
+    slots_[level][slot] = &node;
+    occupied_[level] |= static_cast<uint64_t>(1) << slot;
+    size_++;
+}
+
+void TimerWheel::unlink(TimerNode& node) {
+    if (node.prev_ != nullptr) {
+        node.prev_->next_ = node.next_;
+    } else {
+        slots_[node.level_][node.slot_] = node.next_;
+        if (node.next_ == nullptr) {
+            occupied_[node.level_] &= ~(static_cast<uint64_t>(1) << node.slot_);
+        }
+    }
+    if (node.next_ != nullptr) {
+        node.next_->prev_ = node.prev_;
+    }
+    node.prev_ = node.next_ = nullptr;
+    node.wheel_ = nullptr;
+    size_--;
+}
+
+//把上层某个槽的定时器按新的剩余时间重新放置，它们会落到更低的层
+void TimerWheel::cascade(int level, int slot) {
+    TimerNode* node = slots_[level][slot];
+    slots_[level][slot] = nullptr;
+    occupied_[level] &= ~(static_cast<uint64_t>(1) << slot);
+
+    while (node != nullptr) {
+        TimerNode* next = node->next_;
+        size_--;
+        link(*node);
+        node = next;
+    }
+}
+
+void TimerWheel::advance(uint64_t now_ms) {
+    if (now_ms < start_ms_) {
+        return;
+    }
+    uint64_t target = (now_ms - start_ms_) / tick_ms_;
+
+    while (current_ < target) {
+        //没有任何定时器时直接跳到目标时刻
+        if (size_ == 0) {
+            current_ = target;
+            break;
+        }
+
+        current_++;
+        int slot = static_cast<int>(current_ & SLOT_MASK);
+        //第0层转完一圈时，从上层取下一个槽下放，必要时逐层进位
+        if (slot == 0) {
+            for (int level = 1; level < LEVELS; level++) {
+                int upper = static_cast<int>((current_ >> (SLOT_BITS * level)) & SLOT_MASK);
+                cascade(level, upper);
+                if (upper != 0) {
+                    break;
+                }
+            }
+        }
+
+        //每次只取链表头执行，回调里取消同槽的其他定时器也是安全的
+        while (slots_[0][slot] != nullptr) {
+            TimerNode* node = slots_[0][slot];
+            unlink(*node);
+            //回调可能恢复协程并销毁节点本身（例如sleep的等待对象），先复制一份再调用，调用期间不再访问节点
+            //回调会被反复调度，不能移走；只捕获少量指针的回调复制时不分配内存
+            if (node->callback_) {
+                TimerNode::Callback callback = node->callback_;
+                callback();
+            }
+        }
+    }
+}
+
+int TimerWheel::nextTimeout(uint64_t now_ms) const {
+    if (size_ == 0) {
+        return -1;
+    }
+
+    uint64_t ticks;
+    if (occupied_[0] != 0) {
+        //把位图旋转到以下一个槽为起点，最低的置位即最近的非空槽
+        int next = static_cast<int>((current_ + 1) & SLOT_MASK);
+        uint64_t rotated = (occupied_[0] >> next) | (next == 0 ? 0 : occupied_[0] << (SLOTS - next));
+        ticks = static_cast<uint64_t>(__builtin_ctzll(rotated)) + 1;
+    } else {
+        //只有上层定时器：睡到第0层转完这一圈，届时会进行下放
+        ticks = SLOTS - (current_ & SLOT_MASK);
+    }
+
+    uint64_t deadline = start_ms_ + (current_ + ticks) * tick_ms_;
+    return deadline > now_ms ? static_cast<int>(deadline - now_ms) : 0;
+}
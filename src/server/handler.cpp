@@ -0,0 +1,196 @@
+#include "../../include/handler.h"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if __has_include(<linux/openat2.h>)
+#include <linux/openat2.h>
+#endif
+
+namespace {
+
+const int FILE_OPEN_FLAGS = O_RDONLY | O_CLOEXEC | O_NONBLOCK;
+
+//openat2在5.6之前的内核上不存在，第一次返回ENOSYS后不再尝试
+std::atomic<bool> openat2_unsupported{false};
+
+//由内核保证解析过程（包括符号链接）不离开dir_fd；不支持时返回-1且errno为ENOSYS
+int openBeneath(int dir_fd, const char* path) {
+#if defined(SYS_openat2) && defined(RESOLVE_BENEATH)
+    if (!openat2_unsupported.load(std::memory_order_relaxed)) {
+        struct open_how how = {};
+        how.flags = FILE_OPEN_FLAGS;
+        how.resolve = RESOLVE_BENEATH | RESOLVE_NO_MAGICLINKS;
+        int fd = static_cast<int>(::syscall(SYS_openat2, dir_fd, path, &how, sizeof(how)));
+        if (fd != -1 || errno != ENOSYS) {
+            return fd;
+        }
+        openat2_unsupported.store(true, std::memory_order_relaxed);
+    }
+#else
+    (void)dir_fd;
+    (void)path;
+#endif
+    errno = ENOSYS;
+    return -1;
+}
+
+//没有openat2时逐段打开，每一段都带O_NOFOLLOW：路径中的任何符号链接都被拒绝
+int openComponents(int dir_fd, std::string_view path) {
+    int current = dir_fd;
+    size_t start = 0;
+    while (true) {
+        size_t end = path.find('/', start);
+        bool last = end == std::string_view::npos;
+        std::string name(path.substr(start, last ? std::string_view::npos : end - start));
+        if (last) {
+            int fd = ::openat(current, name.c_str(), FILE_OPEN_FLAGS | O_NOFOLLOW);
+            if (current != dir_fd) {
+                ::close(current);
+            }
+            return fd;
+        }
+        start = end + 1;
+        if (name.empty() || name == ".") {
+            continue;
+        }
+        int next = ::openat(current, name.c_str(), O_PATH | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (current != dir_fd) {
+            ::close(current);
+        }
+        if (next == -1) {
+            return -1;
+        }
+        current = next;
+    }
+}
+
+//反射多项式0xEDB88320的查表法，表在首次使用时生成
+const std::array<uint32_t, 256>& crcTable() {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+}
+
+std::string_view EchoHandler::handle(std::string_view message, std::string&) const {
+    return message;
+}
+
+MessageHandler::Dispatch ChecksumHandler::classify(std::string_view message) const {
+    return message.size() >= offload_threshold_ ? Dispatch::Offload : Dispatch::Inline;
+}
+
+std::string_view ChecksumHandler::handle(std::string_view message, std::string& scratch) const {
+    static const char digits[] = "0123456789abcdef";
+    uint32_t crc = crc32(message);
+
+    scratch.resize(8);
+    for (int i = 7; i >= 0; i--) {
+        scratch[i] = digits[crc & 0xf];
+        crc >>= 4;
+    }
+    return scratch;
+}
+
+uint32_t ChecksumHandler::crc32(std::string_view data) {
+    const auto& table = crcTable();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (unsigned char c : data) {
+        crc = table[(crc ^ c) & 0xff] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+FileHandler::FileHandler(const std::string& root)
+    : root_fd_(::open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)) {
+    if (root_fd_ == -1) {
+        perror("open document root failed");
+    }
+}
+
+FileHandler::~FileHandler() {
+    if (root_fd_ != -1) {
+        ::close(root_fd_);
+    }
+}
+
+bool FileHandler::openFile(std::string_view message, FileReply& file) const {
+    if (!message.empty() && message.back() == '\r') {
+        message.remove_suffix(1);
+    }
+    if (root_fd_ == -1 || message.empty() || message.front() == '/' || message.size() >= PATH_MAX) {
+        return false;
+    }
+    //逐段检查，不允许跳出根目录
+    size_t start = 0;
+    while (start <= message.size()) {
+        size_t end = message.find('/', start);
+        if (end == std::string_view::npos) {
+            end = message.size();
+        }
+        if (message.substr(start, end - start) == "..") {
+            return false;
+        }
+        start = end + 1;
+    }
+
+    //openat会跟随根目录中的符号链接读到根目录外的文件，打开时必须限制在根目录之下
+    std::string path(message);
+    int fd = openBeneath(root_fd_, path.c_str());
+    if (fd == -1 && errno == ENOSYS) {
+        fd = openComponents(root_fd_, message);
+    }
+    if (fd == -1) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    file.fd = fd;
+    file.offset = 0;
+    file.length = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+std::string_view FileHandler::handle(std::string_view, std::string&) const {
+    return "ERR not found";
+}
+
+std::unique_ptr<MessageHandler> createHandler(const std::string& name) {
+    if (name == "echo") {
+        return std::make_unique<EchoHandler>();
+    }
+    if (name == "checksum") {
+        return std::make_unique<ChecksumHandler>();
+    }
+    if (name == "file" || name.rfind("file:", 0) == 0) {
+        auto handler = std::make_unique<FileHandler>(name == "file" ? "." : name.substr(5));
+        if (!handler->isValid()) {
+            return nullptr;
+        }
+        return handler;
+    }
+    return nullptr;
+}
@@ -0,0 +1,401 @@
+#include "../../include/kv_store.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <functional>
+
+KvStore::KvStore(size_t memory_limit)
+    : slots_(INITIAL_SLOTS, Slot{0, EMPTY}), mask_(INITIAL_SLOTS - 1), items_(0),
+      max_pages_(std::clamp<size_t>(memory_limit / PAGE_SIZE, 1, (1u << (32 - BLOCK_BITS)) - 1)), clock_(0),
+      seed_(reinterpret_cast<uintptr_t>(this) | 1) {
+    //按1.25倍增长的大小级别，保持8字节对齐，最后一级整页只放一个条目
+    size_t size = 64;
+    while (size < PAGE_SIZE) {
+        classes_.push_back(SizeClass{size, static_cast<uint32_t>(PAGE_SIZE / size), nullptr, {}});
+        size = (size + size / 4 + 7) & ~static_cast<size_t>(7);
+    }
+    classes_.push_back(SizeClass{PAGE_SIZE, 1, nullptr, {}});
+}
+
+KvStore::~KvStore() = default;
+
+bool KvStore::set(std::string_view key, std::string_view value, uint64_t ttl_ms, uint64_t now_ms) {
+    size_t need = sizeof(Item) + key.size() + value.size();
+    if (key.empty() || key.size() > MAX_KEY || need > PAGE_SIZE) {
+        return false;
+    }
+    uint8_t cls = static_cast<uint8_t>(classFor(need));
+    uint32_t hash = static_cast<uint32_t>(hashKey(key));
+
+    //同一级别的旧条目原地覆盖，否则先删掉旧的再分配
+    Item* item = nullptr;
+    size_t index = find(key, hash);
+    if (index != SIZE_MAX) {
+        Item* old = resolve(slots_[index].ref);
+        if (old->cls == cls) {
+            item = old;
+        } else {
+            eraseSlot(index);
+            items_--;
+            free(old);
+        }
+    }
+    bool inserted = item == nullptr;
+    if (inserted) {
+        item = allocate(cls, now_ms);
+        if (item == nullptr) {
+            return false;
+        }
+        item->hash = hash;
+        item->key_len = static_cast<uint16_t>(key.size());
+        std::memcpy(item->key(), key.data(), key.size());
+    }
+    item->value_len = static_cast<uint32_t>(value.size());
+    std::memcpy(item->value(), value.data(), value.size());
+    item->expires_ms = ttl_ms != 0 ? now_ms + ttl_ms : 0;
+    item->access = ++clock_;
+    if (inserted) {
+        insertSlot(hash, item->ref);
+        items_++;
+    }
+    return true;
+}
+
+bool KvStore::get(std::string_view key, uint64_t now_ms, std::string_view& value) {
+    Item* item = lookup(key, now_ms);
+    if (item == nullptr) {
+        stats_.misses++;
+        return false;
+    }
+    stats_.hits++;
+    value = std::string_view(item->value(), item->value_len);
+    return true;
+}
+
+bool KvStore::erase(std::string_view key) {
+    uint32_t hash = static_cast<uint32_t>(hashKey(key));
+    size_t index = find(key, hash);
+    if (index == SIZE_MAX) {
+        return false;
+    }
+    Item* item = resolve(slots_[index].ref);
+    eraseSlot(index);
+    items_--;
+    free(item);
+    return true;
+}
+
+bool KvStore::ttl(std::string_view key, uint64_t now_ms, int64_t& remaining_ms) {
+    Item* item = lookup(key, now_ms);
+    if (item == nullptr) {
+        return false;
+    }
+    remaining_ms = item->expires_ms == 0 ? -1 : static_cast<int64_t>(item->expires_ms - now_ms);
+    return true;
+}
+
+bool KvStore::expire(std::string_view key, uint64_t ttl_ms, uint64_t now_ms) {
+    Item* item = lookup(key, now_ms);
+    if (item == nullptr) {
+        return false;
+    }
+    item->expires_ms = ttl_ms != 0 ? now_ms + ttl_ms : 0;
+    return true;
+}
+
+std::string_view KvStore::execute(std::string_view command, uint64_t now_ms, std::string& scratch) {
+    size_t space = command.find(' ');
+    std::string_view verb = command.substr(0, space);
+    std::string_view args = space == std::string_view::npos ? std::string_view() : command.substr(space + 1);
+    size_t end = args.find(' ');
+    std::string_view key = args.substr(0, end);
+    bool has_rest = end != std::string_view::npos;
+    std::string_view rest = has_rest ? args.substr(end + 1) : std::string_view();
+
+    if (key.empty() || key.size() > MAX_KEY) {
+        return "ERR bad key";
+    }
+    if (verb == "GET") {
+        std::string_view value;
+        if (has_rest) {
+            return "ERR syntax";
+        }
+        if (!get(key, now_ms, value)) {
+            return "NOT_FOUND";
+        }
+        scratch.assign("VALUE ");
+        scratch.append(value);
+        return scratch;
+    }
+    if (verb == "SET") {
+        if (!has_rest) {
+            return "ERR syntax";
+        }
+        return set(key, rest, 0, now_ms) ? "STORED" : "ERR value too large";
+    }
+    if (verb == "DEL") {
+        if (has_rest) {
+            return "ERR syntax";
+        }
+        return erase(key) ? "DELETED" : "NOT_FOUND";
+    }
+    if (verb == "TTL") {
+        if (!has_rest) {
+            int64_t remaining = 0;
+            if (!ttl(key, now_ms, remaining)) {
+                return "NOT_FOUND";
+            }
+            //剩余不足一秒按一秒报告，未过期的条目不会显示为0
+            scratch.assign("TTL ");
+            scratch.append(remaining < 0 ? std::string("-1") : std::to_string((remaining + 999) / 1000));
+            return scratch;
+        }
+        uint64_t seconds = 0;
+        auto [ptr, ec] = std::from_chars(rest.data(), rest.data() + rest.size(), seconds);
+        if (ec != std::errc() || ptr != rest.data() + rest.size()) {
+            return "ERR syntax";
+        }
+        return expire(key, seconds * 1000, now_ms) ? "OK" : "NOT_FOUND";
+    }
+    return "ERR unknown command";
+}
+
+bool KvStore::parseKey(std::string_view command, std::string_view& key) {
+    size_t space = command.find(' ');
+    std::string_view verb = command.substr(0, space);
+    if (verb != "GET" && verb != "SET" && verb != "DEL" && verb != "TTL") {
+        return false;
+    }
+    key = space == std::string_view::npos ? std::string_view() : command.substr(space + 1);
+    key = key.substr(0, key.find(' '));
+    return true;
+}
+
+//低32位用于分片内的哈希表，高32位留给调用方选择分片，两者互不相关
+uint64_t KvStore::hashKey(std::string_view key) {
+    return std::hash<std::string_view>()(key);
+}
+
+KvStore::Stats KvStore::stats() const {
+    Stats out = stats_;
+    out.items = items_;
+    out.memory_bytes = pages_.size() * PAGE_SIZE;
+    return out;
+}
+
+size_t KvStore::find(std::string_view key, uint32_t hash) {
+    for (size_t i = hash & mask_;; i = (i + 1) & mask_) {
+        const Slot& slot = slots_[i];
+        if (slot.ref == EMPTY) {
+            return SIZE_MAX;
+        }
+        if (slot.hash == hash) {
+            Item* item = resolve(slot.ref);
+            if (std::string_view(item->key(), item->key_len) == key) {
+                return i;
+            }
+        }
+    }
+}
+
+KvStore::Item* KvStore::lookup(std::string_view key, uint64_t now_ms) {
+    size_t index = find(key, static_cast<uint32_t>(hashKey(key)));
+    if (index == SIZE_MAX) {
+        return nullptr;
+    }
+    Item* item = resolve(slots_[index].ref);
+    if (expired(item, now_ms)) {
+        eraseSlot(index);
+        items_--;
+        free(item);
+        stats_.expirations++;
+        return nullptr;
+    }
+    item->access = ++clock_;
+    return item;
+}
+
+void KvStore::insertSlot(uint32_t hash, uint32_t ref) {
+    //负载因子保持在3/4以下，探测链不会太长
+    if ((items_ + 1) * 4 > slots_.size() * 3) {
+        grow();
+    }
+    size_t i = hash & mask_;
+    while (slots_[i].ref != EMPTY) {
+        i = (i + 1) & mask_;
+    }
+    slots_[i] = Slot{hash, ref};
+}
+
+//后面的槽位若其起始位置不在(hole, j]之间，说明它越过了空位，可以前移填补
+void KvStore::eraseSlot(size_t index) {
+    size_t hole = index;
+    for (size_t j = (index + 1) & mask_; slots_[j].ref != EMPTY; j = (j + 1) & mask_) {
+        size_t home = slots_[j].hash & mask_;
+        if (((j - home) & mask_) >= ((j - hole) & mask_)) {
+            slots_[hole] = slots_[j];
+            hole = j;
+        }
+    }
+    slots_[hole].ref = EMPTY;
+}
+
+size_t KvStore::slotOf(const Item* item) {
+    size_t i = item->hash & mask_;
+    while (slots_[i].ref != item->ref) {
+        i = (i + 1) & mask_;
+    }
+    return i;
+}
+
+void KvStore::remove(Item* item) {
+    eraseSlot(slotOf(item));
+    items_--;
+    free(item);
+}
+
+//槽位自带哈希值，扩容时不需要访问条目
+void KvStore::grow() {
+    std::vector<Slot> old(slots_.size() * 2, Slot{0, EMPTY});
+    old.swap(slots_);
+    mask_ = slots_.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.ref == EMPTY) {
+            continue;
+        }
+        size_t i = slot.hash & mask_;
+        while (slots_[i].ref != EMPTY) {
+            i = (i + 1) & mask_;
+        }
+        slots_[i] = slot;
+    }
+}
+
+size_t KvStore::classFor(size_t size) const {
+    auto it = std::lower_bound(classes_.begin(), classes_.end(), size,
+                               [](const SizeClass& cls, size_t need) { return cls.size < need; });
+    return static_cast<size_t>(it - classes_.begin());
+}
+
+KvStore::Item* KvStore::allocate(uint8_t cls, uint64_t now_ms) {
+    SizeClass& sc = classes_[cls];
+    if (sc.free_list == nullptr && !addPage(cls)) {
+        if (!sc.pages.empty()) {
+            evict(cls, now_ms);
+        } else if (!stealPage(cls)) {
+            return nullptr;
+        }
+        if (sc.free_list == nullptr) {
+            return nullptr;
+        }
+    }
+    Item* item = sc.free_list;
+    sc.free_list = item->next();
+    item->live = 1;
+    return item;
+}
+
+void KvStore::free(Item* item) {
+    SizeClass& sc = classes_[item->cls];
+    item->live = 0;
+    item->next() = sc.free_list;
+    sc.free_list = item;
+}
+
+void KvStore::format(uint32_t page_index, uint8_t cls) {
+    SizeClass& sc = classes_[cls];
+    Page& page = pages_[page_index];
+    page.cls = cls;
+    //倒序放入，先分配出去的是页首的块
+    for (uint32_t block = sc.per_page; block-- > 0;) {
+        Item* item = reinterpret_cast<Item*>(page.base.get() + block * sc.size);
+        item->ref = (page_index << BLOCK_BITS) | block;
+        item->cls = cls;
+        item->live = 0;
+        item->next() = sc.free_list;
+        sc.free_list = item;
+    }
+    sc.pages.push_back(page_index);
+}
+
+bool KvStore::addPage(uint8_t cls) {
+    if (pages_.size() >= max_pages_) {
+        return false;
+    }
+    pages_.push_back(Page{std::unique_ptr<char[]>(new char[PAGE_SIZE]), cls});
+    format(static_cast<uint32_t>(pages_.size() - 1), cls);
+    return true;
+}
+
+//空闲链表为空时该级的每个块都有条目，抽样总能命中
+void KvStore::evict(uint8_t cls, uint64_t now_ms) {
+    SizeClass& sc = classes_[cls];
+    Item* victim = nullptr;
+    uint32_t oldest = 0;
+    for (int i = 0; i < EVICTION_SAMPLES; i++) {
+        uint32_t page = sc.pages[random() % sc.pages.size()];
+        Item* item = resolve((page << BLOCK_BITS) | (random() % sc.per_page));
+        if (!item->live) {
+            continue;
+        }
+        if (expired(item, now_ms)) {
+            remove(item);
+            stats_.expirations++;
+            return;
+        }
+        uint32_t age = clock_ - item->access;
+        if (victim == nullptr || age > oldest) {
+            victim = item;
+            oldest = age;
+        }
+    }
+    if (victim != nullptr) {
+        remove(victim);
+        stats_.evictions++;
+    }
+}
+
+bool KvStore::stealPage(uint8_t cls) {
+    size_t donor = classes_.size();
+    for (size_t i = 0; i < classes_.size(); i++) {
+        if (i != cls && !classes_[i].pages.empty() &&
+            (donor == classes_.size() || classes_[i].pages.size() > classes_[donor].pages.size())) {
+            donor = i;
+        }
+    }
+    if (donor == classes_.size()) {
+        return false;
+    }
+
+    SizeClass& from = classes_[donor];
+    uint32_t page_index = from.pages.back();
+    from.pages.pop_back();
+    char* base = pages_[page_index].base.get();
+    for (uint32_t block = 0; block < from.per_page; block++) {
+        Item* item = reinterpret_cast<Item*>(base + block * from.size);
+        if (item->live) {
+            eraseSlot(slotOf(item));
+            items_--;
+            stats_.evictions++;
+        }
+    }
+    //这一页上原本空闲的块从原级别的空闲链表中摘掉
+    Item** link = &from.free_list;
+    while (*link != nullptr) {
+        if (((*link)->ref >> BLOCK_BITS) == page_index) {
+            *link = (*link)->next();
+        } else {
+            link = &(*link)->next();
+        }
+    }
+    format(page_index, cls);
+    return true;
+}
+
+uint32_t KvStore::random() {
+    seed_ ^= seed_ >> 12;
+    seed_ ^= seed_ << 25;
+    seed_ ^= seed_ >> 27;
+    return static_cast<uint32_t>((seed_ * 2685821657736338717ULL) >> 32);
+}
@@ -1,5 +1,29 @@
 #include "../../include/socket.h"
+#include "../../include/socket_address.h"
 #include "../../include/epoll.h"
+#include "../../include/buffer.h"
+#include "../../include/output_queue.h"
+#include "../../include/datagram_batch.h"
+#include "../../include/timer_wheel.h"
+#include "../../include/codec.h"
+#include "../../include/async_logger.h"
+#include "../../include/connection_table.h"
+#include "../../include/task_queue.h"
+#include "../../include/thread_pool.h"
+#include "../../include/handler.h"
+#include "../../include/metrics.h"
+#include "../../include/http.h"
+#include "../../include/server_config.h"
+#include "../../include/coroutine.h"
+#include "../../include/session.h"
+#include "../../include/pipe_pool.h"
+#include "../../include/upstream.h"
+#include "../../include/shared_buffer.h"
+#include "../../include/topic_registry.h"
+#include "../../include/kv_store.h"
+#ifdef HAVE_IO_URING
+#include "../../include/io_uring.h"
+#endif
 #include "spdlog/spdlog.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include "spdlog/sinks/basic_file_sink.h"
@@ -8,216 +32,2511 @@
 #include <vector>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <cstring>
+#include <cstdlib>
+#include <cstdint>
 #include <memory>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <chrono>
 
 #include <signal.h>
+#include <pthread.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
 
-class EpollServer {
+static std::shared_ptr<spdlog::logger> createServerLogger() {
+    try {
+        auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+        auto file_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>("logs/server.log", true);
+
+        std::vector<spdlog::sink_ptr> sinks {console_sink, file_sink};
+        auto logger = std::make_shared<spdlog::logger>("server_logger", sinks.begin(), sinks.end());
+        logger->set_level(spdlog::level::info);
+        logger->set_pattern("[%Y-%m-%d %H:%M:%S] [%l] [%t] %v");
+
+        spdlog::register_logger(logger);
+        return logger;
+    } catch (const spdlog::spdlog_ex& ex) {
+        std::cerr <<"spdlog init failed" << ex.what() << std::endl;
+    }
+    return spdlog::default_logger();
+}
+
+//缓冲区大小须在listen之前设置；busy-poll需要CAP_NET_ADMIN才能超过内核上限，失败时只告警
+static bool applySocketOptions(Socket& socket, const ServerConfig& config, const std::shared_ptr<AsyncLogger>& logger) {
+    if (config.send_buffer > 0 && !socket.setSendBufferSize(config.send_buffer)) {
+        logger->error("Failed to set SO_SNDBUF");
+        return false;
+    }
+    if (config.receive_buffer > 0 && !socket.setReceiveBufferSize(config.receive_buffer)) {
+        logger->error("Failed to set SO_RCVBUF");
+        return false;
+    }
+    //其余都是TCP选项，Unix域套接字不适用
+    if (socket.getFamily() == AF_UNIX) {
+        return true;
+    }
+    if (config.tcp_nodelay && !socket.setNoDelay()) {
+        logger->error("Failed to set TCP_NODELAY");
+        return false;
+    }
+    if (config.defer_accept > 0 && !socket.setDeferAccept(config.defer_accept)) {
+        logger->error("Failed to set TCP_DEFER_ACCEPT");
+        return false;
+    }
+    if (config.fastopen > 0 && !socket.setFastOpen(config.fastopen)) {
+        logger->warn("TCP_FASTOPEN unavailable, continuing without it");
+    }
+    if (config.busy_poll > 0 && !socket.setBusyPoll(config.busy_poll)) {
+        logger->warn("SO_BUSY_POLL unavailable, continuing without it");
+    }
+    return true;
+}
+
+//按地址族创建套接字；主机不支持IPv6时，通配地址退回到IPv4的0.0.0.0
+static bool createSocketFor(Socket& socket, SocketType type, SocketAddress& address) {
+    if (socket.createSocket(type, address.family())) {
+        return true;
+    }
+    if (errno == EAFNOSUPPORT && address.family() == AF_INET6 && address.isWildcard()) {
+        address = SocketAddress::ipv4Any(address.port());
+        return socket.createSocket(type, AF_INET);
+    }
+    return false;
+}
+
+//Unix域套接字文件在进程退出后仍然留在文件系统中，bind前删除；仍有进程在监听的不删，bind随后报EADDRINUSE
+static void removeStaleUnixSocket(const SocketAddress& address) {
+    std::string path = address.unixPath();
+    struct stat st;
+    if (path.empty() || ::lstat(path.c_str(), &st) != 0 || !S_ISSOCK(st.st_mode)) {
+        return;
+    }
+    Socket probe;
+    if (probe.createSocket(SocketType::Stream, AF_UNIX) &&
+        ::connect(probe.getFd(), address.get(), address.length()) < 0 && errno == ECONNREFUSED) {
+        ::unlink(path.c_str());
+    }
+}
+
+//创建非阻塞的监听套接字，reuse_port为true时允许多个reactor绑定同一端口（Unix域套接字不支持，忽略）
+//tuning不为空时按配置设置套接字选项，接受的连接从监听套接字继承这些选项，不必逐个连接设置
+static bool openListener(Socket& socket, SocketAddress address, int backlog, bool reuse_port,
+                         const std::shared_ptr<AsyncLogger>& logger, const ServerConfig* tuning = nullptr) {
+    if (!createSocketFor(socket, SocketType::Stream, address)) {
+        logger->error("Failed to create server socket for {}", address.toString());
+        return false;
+    }
+
+    if (reuse_port && !address.isUnix() && !socket.setReusePort()) {
+        logger->error("Failed to set SO_REUSEPORT");
+        return false;
+    }
+
+    if (!socket.setNonBlocking()) {
+        logger->error("Failed to set non blocking on listener");
+        return false;
+    }
+
+    if (tuning != nullptr && !applySocketOptions(socket, *tuning, logger)) {
+        return false;
+    }
+
+    if (address.isUnix()) {
+        removeStaleUnixSocket(address);
+    }
+    if (!socket.bindSocket(address)) {
+        logger->error("Failed to bind socket to {}", address.toString());
+        return false;
+    }
+
+    if (!socket.listenSocket(backlog)) {
+        logger->error("Failed to listen socket");
+        return false;
+    }
+    return true;
+}
+
+static uint64_t nowUs() {
+    using namespace std::chrono;
+    return static_cast<uint64_t>(duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+//reactor的公共接口，不同事件后端各有一个实现，每个reactor独占一个线程
+//start/run/stop由拥有者调用，stop在run返回后释放资源；post与shutdown可在任意线程调用
+class Reactor {
+public:
+    virtual ~Reactor() = default;
+    virtual bool start() = 0;
+    virtual void run() = 0;
+    virtual void stop() = 0;
+    //把任务交给reactor线程执行
+    virtual bool post(TaskQueue::Task task) = 0;
+    //让run尽快返回：投递一个任务，由reactor线程自己结束循环
+    virtual void shutdown() = 0;
+    //在reactor线程上调用（通过post）：复制一份当前指标
+    virtual void snapshotMetrics(LoopMetrics& out) = 0;
+    //start之后、run之前调用：告知全部reactor，采集指标与广播发布的消息时向它们逐个投递任务
+    virtual void setPeers(std::vector<Reactor*> peers) { (void)peers; }
+    //start之后、run之前调用：在port上提供指标页面；不支持时返回false
+    virtual bool serveMetrics(int port) { (void)port; return false; }
+    //在reactor线程上调用（通过post）：把其他reactor上发布的消息投递给本reactor上订阅了topic的连接
+    //wire是编码好的完整帧，topic是其中的一段；不支持发布订阅时忽略
+    virtual void deliver(const SharedBuffer& wire, std::string_view topic) { (void)wire; (void)topic; }
+    //在reactor线程上调用（通过post）：在本reactor的缓存分片上执行一条命令，回复写入scratch或指向常量
+    virtual std::string_view executeCache(std::string_view command, std::string& scratch) {
+        (void)command;
+        (void)scratch;
+        return "ERR cache unavailable";
+    }
+};
+
+//单个reactor：一个线程、一个Epoll实例、一张客户端表
+class EpollServer : public Reactor {
 private:
-    Socket server_socket_;
+    class Connection;
+
+    //代理连接中一个方向的转发状态
+    struct SpliceFlow {
+        Pipe pipe;          //有数据在途时才从池中借出
+        bool eof = false;   //来源一侧已读到EOF
+        bool shut = false;  //已把EOF转成目标一侧的shutdown(SHUT_WR)
+    };
+
+    //代理连接的后端一侧：后端套接字的事件处理者，握手定时器与两个方向的转发状态
+    struct ProxyLink : public EpollHandler {
+        ProxyLink(EpollServer* owner, Connection* client)
+            : server(owner), conn(client), connect_timer([this] { server->handleConnectTimeout(*conn); }) {}
+        void handleEvent(uint32_t events) override { server->handleUpstreamEvent(*conn, events); }
+
+        EpollServer* server;
+        Connection* conn;
+        Socket upstream;
+        size_t backend = 0;
+        bool connecting = false;    //握手未完成，期间不读取客户端的数据
+        size_t attempts = 0;        //本连接已尝试过的后端数，达到后端总数后放弃
+        SpliceFlow inbound;         //客户端 -> 后端
+        SpliceFlow outbound;        //后端 -> 客户端
+        TimerNode connect_timer;
+    };
+
+    //客户端连接，其指针存放在epoll_event.data.ptr中，事件到达时无需查表
+    //对象由ConnectionTable预分配并反复使用：open接管新套接字，recycle清理后放回空闲链表
+    //配置了会话时连接同时是CoStream，事件只用来唤醒挂起在其上的会话协程
+    class Connection : public EpollHandler, public CoStream {
+    public:
+        explicit Connection(EpollServer* server)
+            : server_(server), generation_(0), input_(&server->pool_), output_(&server->pool_),
+              interest_(0), reading_paused_(false), closed_(true), offloading_(false), metrics_(false),
+              close_after_flush_(false), session_(false), proxy_(false), link_(server, this), http_(MAX_HTTP_REQUEST),
+              last_active_ms_(0), idle_timer_([this] { server_->handleIdleTimeout(*this); }),
+              write_timer_([this] { server_->handleWriteTimeout(*this); }) {}
+
+        void open(Socket&& socket, const SocketAddress& peer, bool metrics = false) {
+            socket_ = std::move(socket);
+            peer_ = peer;
+            peer_name_ = peer.toString();
+            generation_++;
+            interest_ = 0;
+            reading_paused_ = false;
+            closed_ = false;
+            offloading_ = false;
+            metrics_ = metrics;
+            close_after_flush_ = false;
+            proxy_ = !metrics && server_->upstreams_ != nullptr;
+            session_ = !metrics && !proxy_ && server_->session_ != nullptr;
+            http_.reset();
+            last_active_ms_ = server_->now_ms_;
+        }
+
+        //存储块归还给池，定时器从时间轮上摘下，对象本身留给下一个连接
+        //服务器停止时连接不经过关闭流程直接回收，仍挂起的会话协程在这里以失败恢复并结束
+        void recycle() {
+            closed_ = true;
+            abortWaiter();
+            server_->closeUpstream(*this);
+            server_->topics_.unsubscribeAll(this);
+            socket_.close();
+            input_.consume(input_.readable());
+            input_.releaseIfEmpty();
+            output_.clear();
+            deferred_.clear();
+            offloading_ = false;
+            server_->timers_.cancel(idle_timer_);
+            server_->timers_.cancel(write_timer_);
+            closed_ = true;
+        }
+
+        //同一批事件中连接可能已被前面的事件关闭（例如广播时断开慢订阅者），回收要等本轮结束，剩下的事件直接丢弃
+        void handleEvent(uint32_t events) override {
+            if (closed_) {
+                return;
+            }
+            if (session_) {
+                server_->handleSessionEvent(*this, events);
+                return;
+            }
+            if (proxy_) {
+                server_->handleProxyClientEvent(*this, events);
+                return;
+            }
+            if (events & EpollEvents::OUT) {
+                server_->handleClientWritable(*this);
+            }
+            if (closed_) {
+                return;
+            }
+            if (events & EpollEvents::IN) {
+                server_->handleClientData(*this);
+            }
+            if (closed_) {
+                return;
+            }
+            if (events & EpollEvents::ERR) {
+                server_->handleClientError(*this);
+            } else if (events & EpollEvents::HUP) {
+                server_->handleClientDisconnect(*this);
+            }
+        }
+
+        Socket& socket() { return socket_; }
+        const SocketAddress& peer() const { return peer_; }
+        const std::string& peerName() const override { return peer_name_; }
+        uint32_t generation() const { return generation_; }
+        RingBuffer& input() override { return input_; }
+        OutputQueue& output() { return output_; }
+        int fd() const { return socket_.getFd(); }
+        uint32_t interest() const { return interest_; }
+        void setInterest(uint32_t events) { interest_ = events; }
+        bool isReadingPaused() const { return reading_paused_; }
+        void setReadingPaused(bool paused) { reading_paused_ = paused; }
+        bool isClosed() const { return closed_; }
+        bool isOpen() const override { return !closed_; }
+        void markClosed() { closed_ = true; }
+        bool isOffloading() const { return offloading_; }
+        void setOffloading(bool offloading) { offloading_ = offloading; }
+        std::deque<std::string>& deferred() { return deferred_; }
+        bool isMetrics() const { return metrics_; }
+        bool closeAfterFlush() const { return close_after_flush_; }
+        void setCloseAfterFlush() { close_after_flush_ = true; }
+        HttpParser& http() { return http_; }
+        bool isSession() const { return session_; }
+        bool waitingForRead() const { return waiting() == Wait::Read; }
+        void resumeReader(ssize_t result) { wake(Wait::Read, result); }
+        void resumeWriter() { wake(Wait::Write, 1); }
+        void abortSession() { abortWaiter(); }
+        bool isProxy() const { return proxy_; }
+        ProxyLink& link() { return link_; }
+        std::vector<std::string>& topics() { return topics_; }
+        uint64_t lastActive() const { return last_active_ms_; }
+        void touch(uint64_t now_ms) { last_active_ms_ = now_ms; }
+        TimerNode& idleTimer() { return idle_timer_; }
+        TimerNode& writeTimer() { return write_timer_; }
+
+    protected:
+        ssize_t readSome() override { return server_->sessionRead(*this); }
+        bool writeSome(std::string_view data, bool& backlogged) override {
+            return server_->sessionWrite(*this, data, backlogged);
+        }
+        void scheduleTimer(TimerNode& timer, uint64_t ms) override { server_->timers_.schedule(timer, ms); }
+        void cancelTimer(TimerNode& timer) override { server_->timers_.cancel(timer); }
+
+    private:
+        EpollServer* server_;
+        Socket socket_;
+        SocketAddress peer_;        //accept时随accept4取回
+        std::string peer_name_;     //accept时格式化一次，之后写日志不再调用getpeername
+        uint32_t generation_;       //每次open加一，线程池回来的结果据此判断连接是否已被复用
+        RingBuffer input_;      //接收缓冲，存储块按需从reactor的池中借出
+        OutputQueue output_;    //未能立即发出的数据，非空时注册EPOLLOUT
+        uint32_t interest_;     //当前在epoll中注册的事件
+        bool reading_paused_;   //发送队列超过高水位后暂停读取
+        bool closed_;
+        bool offloading_;           //有一条消息正在工作线程池中处理
+        std::deque<std::string> deferred_;  //处理期间到达的后续消息，按顺序等它完成后再处理
+        bool metrics_;              //指标页面的HTTP连接，而不是业务连接
+        bool close_after_flush_;    //发送队列写空后关闭
+        bool session_;              //由会话协程驱动
+        bool proxy_;                //转发到后端，数据不经过输入/发送缓冲
+        ProxyLink link_;
+        std::vector<std::string> topics_;   //已订阅的主题，断开时据此退订
+        HttpParser http_;           //HTTP连接上未完成请求的扫描进度
+        uint64_t last_active_ms_;   //最近一次收到数据的时间，空闲定时器到期时据此判断是否真的空闲
+        TimerNode idle_timer_;
+        TimerNode write_timer_;     //发送队列非空且一直没有进展时到期
+    };
+
+    //一个监听地址，同时是监听套接字的处理者：只登记有待接受的连接，真正的accept在本轮事件处理完后按预算进行
+    struct Listener : public EpollHandler {
+        explicit Listener(EpollServer* owner) : server(owner) {}
+        void handleEvent(uint32_t) override {
+            pending = true;
+            server->accept_pending_ = true;
+        }
+
+        EpollServer* server;
+        Socket own;                 //ReusePort模式下自有的监听套接字
+        Socket* socket = nullptr;   //实际监听的套接字（自有或共享）
+        bool pending = false;       //边沿触发下须一直accept到EAGAIN才会再收到通知
+    };
+
+    //指标监听套接字的处理者
+    class MetricsAcceptor : public EpollHandler {
+    public:
+        explicit MetricsAcceptor(EpollServer* server) : server_(server) {}
+        void handleEvent(uint32_t) override { server_->acceptMetrics(); }
+
+    private:
+        EpollServer* server_;
+    };
+
+    //一次指标采集：向每个reactor投递快照任务，最后一个完成的把结果交回发起的reactor
+    struct MetricsScrape {
+        explicit MetricsScrape(size_t n) : results(n), remaining(n) {}
+        std::vector<LoopMetrics> results;
+        std::atomic<size_t> remaining;
+    };
+
+    //UDP套接字的处理者
+    class DatagramHandler : public EpollHandler {
+    public:
+        explicit DatagramHandler(EpollServer* server) : server_(server) {}
+        void handleEvent(uint32_t) override { server_->handleDatagrams(); }
+
+    private:
+        EpollServer* server_;
+    };
+
+    int id_;
+    ServerConfig config_;
+    std::vector<std::unique_ptr<Listener>> listeners_;     //每个监听地址一个
+    Socket udp_socket_;     //每个reactor各自的SO_REUSEPORT UDP套接字
+    DatagramHandler datagram_handler_;
+    DatagramBatch datagrams_;
+    BufferPool pool_;       //本reactor所有连接共用的缓冲块池
     Epoll epoll_;
-    volatile bool running_;
-    std::unordered_map<int, std::unique_ptr<Socket>> clients_;
-    std::shared_ptr<spdlog::logger> logger_;
+    TaskQueue tasks_;       //其他线程投递过来的任务，eventfd注册在epoll_中
+    std::atomic<bool> running_;
+    std::vector<struct epoll_event> events_;    //常驻的事件缓冲区，每轮wait复用
+    uint64_t now_ms_;       //本轮事件循环开始时的时间，事件处理过程中复用，避免反复取时钟
+    TimerWheel timers_;     //须在连接表之前声明：连接析构时会从时间轮上摘下自己的定时器
+    FramePool frames_;      //会话协程的帧，同样须在连接表之前声明
+    std::unique_ptr<UpstreamGroup> upstreams_;  //代理模式下的后端，连接回收时归还连接数，须在连接表之前声明
+    PipePool pipes_;        //代理转发的中转管道
+    TopicRegistry<Connection> topics_;  //本reactor上连接的订阅，连接回收时退订，须在连接表之前声明
+    ConnectionTable<Connection> clients_;
+    std::vector<Connection*> closing_;      //本轮已关闭、待回收的连接
+    std::unique_ptr<FrameCodec> codec_;     //Raw和Http协议时为空
+    bool http_protocol_;        //业务端口上说HTTP/1.1
+    std::shared_ptr<MessageHandler> handler_;   //分帧协议下处理每条完整消息
+    std::shared_ptr<SessionHandler> session_;   //非空时业务连接由会话协程处理
+    ThreadPool* workers_;       //为空时全部消息都在本线程处理
+    std::string scratch_;       //本线程处理消息时复用的回复缓冲
+    size_t max_connections_;    //达到上限后暂停accept，连接留在内核的监听队列中
+    bool accept_pending_;       //至少一个监听队列中可能还有连接
+    bool at_capacity_;
+    int reserve_fd_;            //备用fd，EMFILE时释放它来接受并立即关闭一个连接，使监听队列不至于卡死
+    TimerNode accept_retry_timer_;  //accept遇到无法立即恢复的错误时稍后重试
+    LoopMetrics metrics_;       //只由本线程修改
+    Socket metrics_socket_;     //只有提供指标页面的reactor才打开
+    MetricsAcceptor metrics_acceptor_;
+    std::vector<Reactor*> peers_;       //全部reactor（含自己），用于汇总指标、广播发布的消息和转交缓存命令
+    size_t shard_;                      //本reactor在peers_中的位置，也是缓存分片号
+    std::unique_ptr<KvStore> cache_;    //本reactor的缓存分片，启用缓存时在setPeers中创建
+    std::shared_ptr<AsyncLogger> logger_;
+
+    static const size_t BUFFER_SIZE = 16384;
+    //启动时预先构造的连接对象数，超出后按块扩容
+    static const size_t PREALLOCATED_CONNECTIONS = 1024;
+    //每轮事件循环最多accept的连接数，连接风暴时已有连接的事件不会被饿死
+    static const int ACCEPT_BUDGET = 64;
+    static const uint64_t ACCEPT_RETRY_MS = 100;
+    //发送队列超过高水位时停止读取该连接，降到低水位以下再恢复
+    static const size_t OUTPUT_HIGH_WATER = 1024 * 1024;
+    static const size_t OUTPUT_LOW_WATER = 256 * 1024;
+    //等待前一条消息处理完的后续消息数达到上限时同样暂停读取
+    static const size_t MAX_DEFERRED_MESSAGES = 256;
+    //每次recvmmsg/sendmmsg处理的数据报个数，以及一次就绪事件最多处理的批数
+    static const size_t DATAGRAM_BATCH = 64;
+    static const size_t DATAGRAM_SIZE = 2048;
+    static const int DATAGRAM_BATCHES_PER_EVENT = 16;
+    //连接超过IDLE_TIMEOUT_MS没有收到数据，或发送队列超过WRITE_TIMEOUT_MS没有任何进展时关闭
+    static const uint64_t IDLE_TIMEOUT_MS = 60 * 1000;
+    static const uint64_t WRITE_TIMEOUT_MS = 30 * 1000;
+    static const uint64_t TIMER_TICK_MS = 10;
+    //整帧必须能放进一个输入缓冲块
+    static constexpr size_t MAX_FRAME = BUFFER_SIZE - LengthPrefixedCodec::HEADER_SIZE;
+    //HTTP请求（请求行+头部+正文）必须能放进一个输入缓冲块
+    static const size_t MAX_HTTP_REQUEST = BUFFER_SIZE;
+    //每个reactor缓存的空闲中转管道数
+    static const size_t PIPE_POOL_IDLE = 64;
+    //主题名的最大长度，以及每个连接最多订阅的主题数
+    static const size_t MAX_TOPIC_LENGTH = 256;
+    static const size_t MAX_TOPICS_PER_CONNECTION = 64;
+
+public:
+    //shared_listeners为空时按config.listen为每个地址打开自有的SO_REUSEPORT监听套接字，否则与其他reactor共享这些套接字
+    EpollServer(int id, const ServerConfig& config, std::shared_ptr<AsyncLogger> logger,
+                std::vector<Socket>* shared_listeners = nullptr, size_t max_connections = SIZE_MAX,
+                std::shared_ptr<MessageHandler> handler = nullptr, ThreadPool* workers = nullptr,
+                std::shared_ptr<SessionHandler> session = nullptr)
+        : id_(id), config_(config),
+          datagram_handler_(this), datagrams_(DATAGRAM_BATCH, DATAGRAM_SIZE), pool_(BUFFER_SIZE), running_(false),
+          events_(static_cast<size_t>(std::max(1, config.events_per_wait))), now_ms_(TimerWheel::nowMs()),
+          timers_(TIMER_TICK_MS, now_ms_),
+          upstreams_(config.upstreams.empty() ? nullptr
+                     : std::make_unique<UpstreamGroup>(config.upstreams, config.balance, config.upstream_pool)),
+          pipes_(PIPE_POOL_IDLE),
+          clients_([this](void* storage) { return new (storage) Connection(this); }),
+          codec_(createCodec(config.protocol)), http_protocol_(config.protocol == Protocol::Http),
+          handler_(handler ? std::move(handler) : std::make_shared<EchoHandler>()), session_(std::move(session)),
+          workers_(workers),
+          max_connections_(max_connections), accept_pending_(false),
+          at_capacity_(false), reserve_fd_(-1),
+          accept_retry_timer_([this] { retryAccept(); }), metrics_acceptor_(this), shard_(0),
+          logger_(std::move(logger)) {
+        clients_.reserve(PREALLOCATED_CONNECTIONS, static_cast<int>(PREALLOCATED_CONNECTIONS));
+        closing_.reserve(events_.size());
+        for (size_t i = 0; i < config_.listen.size(); i++) {
+            auto listener = std::make_unique<Listener>(this);
+            if (shared_listeners != nullptr && i < shared_listeners->size() && (*shared_listeners)[i].isValid()) {
+                listener->socket = &(*shared_listeners)[i];
+            }
+            listeners_.push_back(std::move(listener));
+        }
+    }
+
+    ~EpollServer() override {
+        stop();
+    }
+
+    bool start() override {
+        for (size_t i = 0; i < listeners_.size(); i++) {
+            Listener& listener = *listeners_[i];
+            if (listener.socket != nullptr) {
+                continue;
+            }
+            if (!openListener(listener.own, config_.listen[i], config_.backlog, true, logger_, &config_)) {
+                return false;
+            }
+            //绑定了CPU时让内核把在这个CPU上收到的连接优先分给本reactor，连接的软中断与处理落在同一个核上
+            if (!config_.cpus.empty()) {
+                listener.own.setIncomingCpu(config_.cpus[static_cast<size_t>(id_) % config_.cpus.size()]);
+            }
+            listener.socket = &listener.own;
+        }
+
+        if (!epoll_.create()) {
+            logger_->error("Failed to create epoll");
+            return false;
+        }
+
+        if (!tasks_.open() || !epoll_.add(tasks_.getFd(), EpollEvents::IN, &tasks_)) {
+            logger_->error("Failed to register task queue");
+            return false;
+        }
+
+        //共享监听套接字时只唤醒一个等待者，避免所有reactor同时争抢accept
+        for (auto& listener : listeners_) {
+            uint32_t listen_events = EpollEvents::IN | EpollEvents::ET;
+            if (listener->socket != &listener->own) {
+                listen_events |= EpollEvents::EXCLUSIVE;
+            }
+            if (!epoll_.add(listener->socket->getFd(), listen_events, listener.get())) {
+                logger_->error("Failed to add events in start()");
+                return false;
+            }
+        }
+
+        if (!startDatagram()) {
+            return false;
+        }
+
+        reserve_fd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+        if (reserve_fd_ < 0) {
+            logger_->warn("Failed to open reserve fd, EMFILE recovery disabled");
+        }
+
+        if (upstreams_) {
+            upstreams_->refill(now_ms_);
+        }
+
+        logger_->info("Reactor {} started", id_);
+        running_ = true;
+        return true;
+    }
+
+    //wait的超时取自时间轮中最近的到期时间，没有定时器时一直阻塞
+    void run() override {
+        FramePool::Scope frame_scope(frames_);
+        while (running_) {
+            //还有未接受完的连接时不阻塞，先处理已就绪的事件再继续accept
+            bool accept_ready = accept_pending_ && clients_.size() < max_connections_;
+            int n = epoll_.wait(events_, accept_ready ? 0 : timers_.nextTimeout(now_ms_));
+            //EINTR已在wait中当作0返回；其他错误重试也不会恢复，结束本reactor，避免空转刷屏
+            if (n < 0) {
+                if (running_) {
+                    logger_->error("Reactor {} epoll_wait failed: {}, stopping", id_, std::strerror(errno));
+                    running_ = false;
+                }
+                break;
+            }
+            now_ms_ = TimerWheel::nowMs();
+            uint64_t loop_start = nowUs();
+            metrics_.wait_calls++;
+            if (n > 0) {
+                metrics_.events += static_cast<uint64_t>(n);
+            }
+            metrics_.events_per_wait.record(n > 0 ? static_cast<uint64_t>(n) : 0);
+
+            if (n > 0) {
+                Epoll::dispatch(std::span<const struct epoll_event>(events_.data(), n));
+            }
+            timers_.advance(now_ms_);
+            if (accept_pending_) {
+                handleNewConnection();
+            }
+
+            //同一批事件中可能还有指向已关闭连接的指针，等整批处理完再回收
+            recycleClosed();
+            metrics_.loop_us.record(nowUs() - loop_start);
+        }
+    }
+
+    void recycleClosed() {
+        for (Connection* conn : closing_) {
+            clients_.recycle(conn);
+        }
+        closing_.clear();
+    }
+
+    //调度一个一次性定时器，节点由调用方持有
+    void runAfter(TimerNode& timer, uint64_t delay_ms) {
+        timers_.schedule(timer, delay_ms);
+    }
+
+    void stop() override {
+        running_ = false;
+        if (epoll_.getFd() == -1) {
+            return;
+        }
+        clients_.forEach([this](Connection& conn) {
+            clients_.detach(conn.fd());
+            clients_.recycle(&conn);
+        });
+        recycleClosed();
+        if (reserve_fd_ >= 0) {
+            ::close(reserve_fd_);
+            reserve_fd_ = -1;
+        }
+        listeners_.clear();
+        udp_socket_.close();
+        metrics_socket_.close();
+        tasks_.close();
+        epoll_.close();
+        logger_->info("Reactor {} stopped", id_);
+    }
+
+    bool post(TaskQueue::Task task) override {
+        return tasks_.post(std::move(task));
+    }
+
+    void shutdown() override {
+        if (!post([this] { running_ = false; })) {
+            running_ = false;
+        }
+    }
+
+    //计数直接复制；连接数、队列深度等瞬时值在这里遍历连接表算出，平时不维护
+    void snapshotMetrics(LoopMetrics& out) override {
+        out = metrics_;
+        out.tasks = tasks_.executed();
+        clients_.forEach([&out](Connection& conn) {
+            if (conn.isMetrics()) {
+                return;
+            }
+            out.active_connections++;
+            out.output_queue_bytes += conn.output().size();
+            out.deferred_messages += conn.deferred().size();
+            if (conn.isReadingPaused()) {
+                out.paused_connections++;
+            }
+        });
+        out.subscriptions = topics_.subscriptions();
+        if (cache_) {
+            KvStore::Stats stats = cache_->stats();
+            out.cache_items = stats.items;
+            out.cache_memory_bytes = stats.memory_bytes;
+            out.cache_hits = stats.hits;
+            out.cache_misses = stats.misses;
+            out.cache_evictions = stats.evictions;
+            out.cache_expirations = stats.expirations;
+        }
+    }
+
+    //分片数等于reactor数，到这里才知道，缓存分片因此在这里创建
+    void setPeers(std::vector<Reactor*> peers) override {
+        peers_ = std::move(peers);
+        auto self = std::find(peers_.begin(), peers_.end(), this);
+        shard_ = self != peers_.end() ? static_cast<size_t>(self - peers_.begin()) : 0;
+        if (config_.cache && codec_) {
+            cache_ = std::make_unique<KvStore>(config_.cache_memory / std::max<size_t>(1, peers_.size()));
+        }
+    }
+
+    std::string_view executeCache(std::string_view command, std::string& scratch) override {
+        if (!cache_) {
+            return "ERR cache unavailable";
+        }
+        return cache_->execute(command, now_ms_, scratch);
+    }
+
+    bool serveMetrics(int port) override {
+        if (!openListener(metrics_socket_, SocketAddress::any(port), config_.backlog, false, logger_)) {
+            return false;
+        }
+        if (!epoll_.add(metrics_socket_.getFd(), EpollEvents::IN | EpollEvents::ET, &metrics_acceptor_)) {
+            metrics_socket_.close();
+            return false;
+        }
+        logger_->info("Reactor {} serving metrics on port {}", id_, port);
+        return true;
+    }
+
+    //订阅者列表倒序遍历，断开慢订阅者时当前项被末尾元素填补，不影响尚未访问的部分
+    //断开可能删除整个主题，因此每次断开后重新查找列表
+    void deliver(const SharedBuffer& wire, std::string_view topic) override {
+        const auto* subscribers = topics_.find(topic);
+        size_t i = subscribers != nullptr ? subscribers->size() : 0;
+        while (i > 0) {
+            Connection& conn = *(*subscribers)[--i];
+            OutputQueue& output = conn.output();
+            if (output.size() >= config_.subscriber_queue) {
+                if (config_.slow_subscriber == SlowSubscriber::Drop) {
+                    metrics_.fanout_drops++;
+                    continue;
+                }
+                metrics_.slow_disconnects++;
+                logger_->warn("Subscriber {} has {} byte(s) queued, disconnecting", conn.peerName(), output.size());
+                handleClientDisconnect(conn);
+                subscribers = topics_.find(topic);
+                i = subscribers != nullptr ? std::min(i, subscribers->size()) : 0;
+                continue;
+            }
+            bool was_empty = output.empty();
+            output.appendShared(wire);
+            metrics_.fanout_deliveries++;
+            //原本为空的队列立即尝试发送，否则等EPOLLOUT；发送出错时连接在这里被关闭
+            if (was_empty) {
+                handleClientWritable(conn);
+                if (conn.isClosed()) {
+                    subscribers = topics_.find(topic);
+                    i = subscribers != nullptr ? std::min(i, subscribers->size()) : 0;
+                }
+            }
+        }
+    }
+
+private:
+    static std::unique_ptr<FrameCodec> createCodec(Protocol protocol) {
+        switch (protocol) {
+            case Protocol::LengthPrefixed:
+                return std::make_unique<LengthPrefixedCodec>(MAX_FRAME);
+            case Protocol::Line:
+                return std::make_unique<DelimiterCodec>(MAX_FRAME, '\n');
+            case Protocol::Raw:
+            case Protocol::Http:
+                break;
+        }
+        return nullptr;
+    }
+
+    //UDP与第一个IP监听地址共用地址和端口，同样借助SO_REUSEPORT由内核在各reactor间分发数据报；只有Unix地址时不提供UDP
+    //使用水平触发，单次事件处理的批数有上限，剩余的数据报留到下一轮，避免饿死TCP连接
+    bool startDatagram() {
+        auto inet = std::find_if(config_.listen.begin(), config_.listen.end(),
+                                 [](const SocketAddress& address) { return address.isInet(); });
+        if (inet == config_.listen.end()) {
+            return true;
+        }
+        SocketAddress address = *inet;
+        if (!createSocketFor(udp_socket_, SocketType::Datagram, address) || !udp_socket_.setReusePort() ||
+            !udp_socket_.setNonBlocking() || !udp_socket_.bindSocket(address)) {
+            logger_->error("Failed to create udp socket");
+            return false;
+        }
+
+        if (!epoll_.add(udp_socket_.getFd(), EpollEvents::IN, &datagram_handler_)) {
+            logger_->error("Failed to add udp events in start()");
+            return false;
+        }
+        return true;
+    }
+
+    //一次recvmmsg收取一批数据报，再用一次sendmmsg原样回显给各自的发送方
+    void handleDatagrams() {
+        for (int i = 0; i < DATAGRAM_BATCHES_PER_EVENT; i++) {
+            int received = udp_socket_.recvBatch(datagrams_);
+            if (received <= 0) {
+                break;
+            }
+            logger_->debug("Received {} datagram(s)", received);
+
+            datagrams_.prepareReply();
+            int sent = udp_socket_.sendBatch(datagrams_);
+            if (sent < received) {
+                //UDP不保证送达，发送缓冲区满时直接丢弃剩余的回显
+                logger_->debug("Dropped {} datagram reply(s)", received - (sent > 0 ? sent : 0));
+            }
+
+            if (static_cast<size_t>(received) < datagrams_.capacity()) {
+                break;
+            }
+        }
+    }
+
+    //每轮在全部监听地址上合计最多接受ACCEPT_BUDGET个连接；预算用完或达到连接上限时accept_pending_保持为true，下一轮继续
+    void handleNewConnection() {
+        int budget = ACCEPT_BUDGET;
+        bool pending = false;
+        for (auto& listener : listeners_) {
+            if (listener->pending) {
+                acceptFrom(*listener, budget);
+            }
+            pending = pending || listener->pending;
+        }
+        accept_pending_ = pending;
+    }
+
+    void retryAccept() {
+        for (auto& listener : listeners_) {
+            listener->pending = true;
+        }
+        accept_pending_ = true;
+    }
+
+    void acceptFrom(Listener& listener, int& budget) {
+        SocketAddress peer;
+
+        for (; budget > 0; budget--) {
+            if (clients_.size() >= max_connections_) {
+                if (!at_capacity_) {
+                    logger_->warn("Reactor {} reached {} connection(s), pausing accept", id_, max_connections_);
+                    at_capacity_ = true;
+                }
+                return;
+            }
+            at_capacity_ = false;
+
+            Socket client_socket = listener.socket->acceptNonBlocking(peer);
+            if (!client_socket.isValid()) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    listener.pending = false;
+                    return;
+                }
+                metrics_.accept_errors++;
+                if (errno == ECONNABORTED || errno == EINTR || errno == EPROTO || errno == EPERM) {
+                    continue;
+                }
+                if ((errno == EMFILE || errno == ENFILE) && shedWithReserveFd(*listener.socket)) {
+                    continue;
+                }
+                logger_->error("accept failed: {}, retrying in {} ms", std::strerror(errno), static_cast<uint64_t>(ACCEPT_RETRY_MS));
+                listener.pending = false;
+                timers_.schedule(accept_retry_timer_, ACCEPT_RETRY_MS);
+                return;
+            }
+
+            int client_fd = client_socket.getFd();
+            Connection* conn = clients_.acquire(client_fd);
+            conn->open(std::move(client_socket), peer);
+
+            //代理连接一直关注EPOLLOUT：边沿触发下它只在发送缓冲区由满转空时通知，省去反复epoll_ctl
+            uint32_t events = EpollEvents::IN | EpollEvents::ET | EpollEvents::HUP | EpollEvents::ERR;
+            if (conn->isProxy()) {
+                events |= EpollEvents::OUT;
+            }
+            if (!epoll_.add(client_fd, events, conn)) {
+                logger_->error("Failed to add events in handleNewConnection()");
+                clients_.detach(client_fd);
+                clients_.recycle(conn);
+                continue;
+            }
+            conn->setInterest(events);
+
+            timers_.schedule(conn->idleTimer(), IDLE_TIMEOUT_MS);
+            metrics_.accepts++;
+            logger_->info("New connection accepted from {}", conn->peerName());
+            if (conn->isSession()) {
+                runSession(*conn, conn->generation());
+            } else if (conn->isProxy()) {
+                startProxy(*conn);
+            }
+        }
+    }
+
+    //fd耗尽：让出备用fd，接受并立即关闭一个连接（对端会收到关闭而不是一直挂在队列里），再重新占住备用fd
+    bool shedWithReserveFd(Socket& listen_socket) {
+        if (reserve_fd_ < 0) {
+            return false;
+        }
+        ::close(reserve_fd_);
+        SocketAddress peer;
+        Socket rejected = listen_socket.acceptNonBlocking(peer);
+        bool shed = rejected.isValid();
+        rejected.close();
+        reserve_fd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+        if (shed) {
+            logger_->warn("Out of file descriptors, rejected connection from {}", peer.toString());
+        }
+        return shed;
+    }
+
+    //指标页面的连接很少，不受accept预算和连接上限限制
+    void acceptMetrics() {
+        SocketAddress peer;
+        while (true) {
+            Socket client_socket = metrics_socket_.acceptNonBlocking(peer);
+            if (!client_socket.isValid()) {
+                return;
+            }
+            int client_fd = client_socket.getFd();
+            Connection* conn = clients_.acquire(client_fd);
+            conn->open(std::move(client_socket), peer, true);
+
+            uint32_t events = EpollEvents::IN | EpollEvents::ET | EpollEvents::HUP | EpollEvents::ERR;
+            if (!epoll_.add(client_fd, events, conn)) {
+                clients_.detach(client_fd);
+                clients_.recycle(conn);
+                continue;
+            }
+            conn->setInterest(events);
+            timers_.schedule(conn->idleTimer(), IDLE_TIMEOUT_MS);
+        }
+    }
+
+    //HTTP：在输入缓冲上原地逐个解析完整的请求，回复只追加到发送队列，由handleClientData在读完后统一写出
+    //采集指标等需要等待的请求期间暂停解析，后面流水线发来的请求留在输入缓冲中，保证回复顺序
+    //返回false表示连接已被关闭
+    bool handleHttp(Connection& conn) {
+        RingBuffer& input = conn.input();
+        HttpRequest request;
+
+        while (!conn.isOffloading() && !conn.closeAfterFlush() && !input.empty()) {
+            input.linearize();
+            struct iovec iov[2];
+            input.readableSegments(iov);
+            std::string_view data(static_cast<const char*>(iov[0].iov_base), iov[0].iov_len);
+
+            HttpParser::Result result = conn.http().parse(data, request);
+            if (result == HttpParser::Result::NeedMore) {
+                return true;
+            }
+            if (result == HttpParser::Result::Error) {
+                logger_->warn("Malformed HTTP request from {}", conn.peerName());
+                writeHttpResponse(conn, conn.http().errorStatus(), "text/plain", httpStatusReason(conn.http().errorStatus()),
+                                  false, false);
+                input.consume(input.readable());
+                return true;
+            }
+
+            metrics_.messages++;
+            handleHttpRequest(conn, request);
+            if (conn.isClosed()) {
+                return false;
+            }
+            input.consume(request.wire_size);
+            conn.http().reset();
+        }
+        //已决定关闭的连接不再理会后续数据
+        if (conn.closeAfterFlush()) {
+            input.consume(input.readable());
+        }
+        return true;
+    }
+
+    //内置/health与/metrics；业务端口上的其他路径：文件处理器按路径发送文件，其他处理器把请求正文交给handle
+    void handleHttpRequest(Connection& conn, const HttpRequest& request) {
+        bool head = request.method == "HEAD";
+        if (request.method != "GET" && !head && request.method != "POST") {
+            writeHttpResponse(conn, 405, "text/plain", "Method Not Allowed", request.keep_alive, head);
+            return;
+        }
+
+        std::string_view path = request.path();
+        if (path == "/health") {
+            writeHttpResponse(conn, 200, "text/plain", "ok\n", request.keep_alive, head);
+            return;
+        }
+        if (path == "/metrics") {
+            conn.setOffloading(true);
+            startScrape(conn, request.keep_alive, head);
+            return;
+        }
+        if (conn.isMetrics()) {
+            writeHttpResponse(conn, 404, "text/plain", "Not Found", request.keep_alive, head);
+            return;
+        }
+
+        uint64_t start = nowUs();
+        FileReply file;
+        if (path.size() > 1 && handler_->openFile(path.substr(1), file)) {
+            metrics_.handler_us.record(nowUs() - start);
+            char buf[256];
+            size_t len = formatHttpResponseHead(buf, sizeof(buf), 200, "application/octet-stream", file.length,
+                                                request.keep_alive);
+            conn.output().append(buf, len);
+            if (head) {
+                ::close(file.fd);
+            } else {
+                conn.output().appendFile(file.fd, file.offset, file.length);
+            }
+            if (!request.keep_alive) {
+                conn.setCloseAfterFlush();
+            }
+            return;
+        }
+        if (handler_->servesFiles()) {
+            writeHttpResponse(conn, 404, "text/plain", "Not Found", request.keep_alive, head);
+            return;
+        }
+        std::string_view response = handler_->handle(request.body, scratch_);
+        metrics_.handler_us.record(nowUs() - start);
+        writeHttpResponse(conn, 200, "text/plain", response, request.keep_alive, head);
+    }
+
+    //响应头格式化到栈上，连同正文拷贝进发送队列，不立即写出
+    void writeHttpResponse(Connection& conn, int status, std::string_view content_type, std::string_view body,
+                           bool keep_alive, bool head) {
+        char buf[256];
+        size_t len = formatHttpResponseHead(buf, sizeof(buf), status, content_type, body.size(), keep_alive);
+        conn.output().append(buf, len);
+        if (!head) {
+            conn.output().append(body.data(), body.size());
+        }
+        if (!keep_alive) {
+            conn.setCloseAfterFlush();
+        }
+    }
+
+    //一次指标采集：向每个reactor投递快照任务，最后一个完成的把结果交回本reactor
+    void startScrape(Connection& conn, bool keep_alive, bool head) {
+        auto scrape = std::make_shared<MetricsScrape>(peers_.size());
+        Connection* target = &conn;
+        uint32_t generation = conn.generation();
+
+        auto finish = [this, scrape, target, generation, keep_alive, head] {
+            post([this, scrape, target, generation, keep_alive, head] {
+                finishScrape(*target, generation, *scrape, keep_alive, head);
+            });
+        };
+        if (peers_.empty()) {
+            finish();
+            return;
+        }
+        for (size_t i = 0; i < peers_.size(); i++) {
+            Reactor* peer = peers_[i];
+            bool posted = peer->post([peer, scrape, i, finish] {
+                peer->snapshotMetrics(scrape->results[i]);
+                if (scrape->remaining.fetch_sub(1) == 1) {
+                    finish();
+                }
+            });
+            if (!posted && scrape->remaining.fetch_sub(1) == 1) {
+                finish();
+            }
+        }
+    }
+
+    //写出指标后继续解析采集期间留在输入缓冲中的请求
+    void finishScrape(Connection& conn, uint32_t generation, const MetricsScrape& scrape, bool keep_alive, bool head) {
+        if (conn.generation() != generation || conn.isClosed()) {
+            return;
+        }
+        conn.setOffloading(false);
+
+        std::vector<std::pair<std::string, uint64_t>> globals;
+        if (workers_ != nullptr) {
+            globals.emplace_back("worker_threads", workers_->size());
+            globals.emplace_back("worker_queue_depth", workers_->pending());
+        }
+        std::string body = formatPrometheus(scrape.results, globals);
+        writeHttpResponse(conn, 200, "text/plain; version=0.0.4", body, keep_alive, head);
+        if (!conn.input().empty() && !handleHttp(conn)) {
+            return;
+        }
+        handleClientWritable(conn);
+    }
+
+    void handleClientData(Connection& conn) {
+        Socket& client_socket = conn.socket();
+        RingBuffer& input = conn.input();
+
+        while (true) {
+            //对端读得慢时不再读取新数据，让背压传导回对端的发送窗口
+            //HTTP连接在等待采集结果时同样暂停，已读入的请求留在输入缓冲中
+            if (conn.output().size() >= OUTPUT_HIGH_WATER || conn.deferred().size() >= MAX_DEFERRED_MESSAGES ||
+                (conn.isOffloading() && isHttp(conn))) {
+                conn.setReadingPaused(true);
+                break;
+            }
+
+            ssize_t bytes_read = client_socket.recv(input);
+            metrics_.read_calls++;
+
+            if (bytes_read > 0) {
+                conn.touch(now_ms_);
+                metrics_.bytes_in += static_cast<uint64_t>(bytes_read);
+                if (isHttp(conn)) {
+                    if (!handleHttp(conn)) {
+                        return;
+                    }
+                    continue;
+                }
+                if (codec_) {
+                    if (!handleFrames(conn)) {
+                        return;
+                    }
+                    continue;
+                }
+
+                //逐块的内容日志只在debug级别输出，默认的info级别下不拷贝负载
+                if (logger_->shouldLog(spdlog::level::debug)) {
+                    struct iovec iov[2];
+                    int cnt = input.readableSegments(iov);
+                    std::string_view first(static_cast<const char*>(iov[0].iov_base), iov[0].iov_len);
+                    std::string_view second = cnt > 1 ? std::string_view(static_cast<const char*>(iov[1].iov_base), iov[1].iov_len) : std::string_view();
+                    logger_->debug("Received from {} : {}{}", conn.peerName(), first, second);
+                }
+
+                if (!echo(conn)) {
+                    logger_->error("Failed to send data to client");
+                    handleClientDisconnect(conn);
+                    return;
+                }
+            } else if (bytes_read == 0) {
+                handleClientDisconnect(conn);
+                return;
+            } else if (bytes_read == -1) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    metrics_.read_eagain++;
+                    break;
+                } else {
+                    handleClientError(conn);
+                    return;
+                }
+            }
+        }
+
+        input.releaseIfEmpty();
+        //HTTP回复在本次读完后合并成一次写出
+        if (isHttp(conn) && !conn.output().empty()) {
+            handleClientWritable(conn);
+            return;
+        }
+        updateInterest(conn);
+    }
+
+    bool isHttp(const Connection& conn) const {
+        return http_protocol_ || conn.isMetrics();
+    }
+
+    //从输入缓冲中逐个解出完整帧交给handleMessage，处理完再消费，帧视图在此期间一直有效
+    //返回false表示连接已被关闭
+    bool handleFrames(Connection& conn) {
+        RingBuffer& input = conn.input();
+        Frame frame;
+
+        while (true) {
+            FrameCodec::DecodeResult result = codec_->decode(input, frame);
+            if (result == FrameCodec::DecodeResult::NeedMore) {
+                return true;
+            }
+            if (result == FrameCodec::DecodeResult::Error) {
+                logger_->error("Malformed or oversized frame, closing");
+                handleClientDisconnect(conn);
+                return false;
+            }
+
+            handleMessage(conn, frame.payload);
+            if (conn.isClosed()) {
+                return false;
+            }
+            input.consume(frame.wire_size);
+        }
+    }
+
+    //一条完整消息：前面还有消息在工作线程池中处理时先排队，保证同一连接的回复顺序与请求一致
+    void handleMessage(Connection& conn, std::string_view message) {
+        logger_->debug("Received message from {} : {}", conn.peerName(), message);
+        if (conn.isOffloading()) {
+            conn.deferred().emplace_back(message);
+            return;
+        }
+        processMessage(conn, message);
+    }
+
+    //廉价的消息就地处理并写出；处理器要求转交的消息拷贝一份交给线程池
+    void processMessage(Connection& conn, std::string_view message) {
+        metrics_.messages++;
+        if (config_.pubsub && handlePubSub(conn, message)) {
+            return;
+        }
+        if (cache_ && handleCache(conn, message)) {
+            return;
+        }
+        if (workers_ != nullptr && handler_->classify(message) == MessageHandler::Dispatch::Offload) {
+            offload(conn, std::string(message));
+            return;
+        }
+
+        uint64_t start = nowUs();
+        FileReply file;
+        if (handler_->openFile(message, file)) {
+            metrics_.handler_us.record(nowUs() - start);
+            if (!sendFile(conn, file)) {
+                logger_->error("Failed to send file to client");
+                handleClientDisconnect(conn);
+            }
+            return;
+        }
+        std::string_view response = handler_->handle(message, scratch_);
+        metrics_.handler_us.record(nowUs() - start);
+        if (!sendMessage(conn, response)) {
+            logger_->error("Failed to send data to client");
+            handleClientDisconnect(conn);
+        }
+    }
+
+    //发布订阅命令：SUB topic、UNSUB topic、PUB topic payload，回复OK或ERR原因；不是这三个命令时返回false
+    //订阅者收到的消息为"MSG topic payload"
+    bool handlePubSub(Connection& conn, std::string_view message) {
+        size_t space = message.find(' ');
+        std::string_view command = message.substr(0, space);
+        if (command != "SUB" && command != "UNSUB" && command != "PUB") {
+            return false;
+        }
+        std::string_view args = space == std::string_view::npos ? std::string_view() : message.substr(space + 1);
+        size_t end = args.find(' ');
+        std::string_view topic = args.substr(0, end);
+        std::string_view payload = end == std::string_view::npos ? std::string_view() : args.substr(end + 1);
+
+        std::string_view reply = "OK";
+        if (topic.empty() || topic.size() > MAX_TOPIC_LENGTH || (command != "PUB" && end != std::string_view::npos)) {
+            reply = "ERR bad topic";
+        } else if (command == "SUB") {
+            if (conn.topics().size() >= MAX_TOPICS_PER_CONNECTION) {
+                reply = "ERR too many topics";
+            } else {
+                topics_.subscribe(topic, &conn);
+            }
+        } else if (command == "UNSUB") {
+            topics_.unsubscribe(topic, &conn);
+        } else if (!publish(topic, payload)) {
+            reply = "ERR message too large";
+        }
+        //发布者自己也可能订阅了该主题，投递时若发送出错已被关闭
+        if (conn.isClosed()) {
+            return true;
+        }
+        if (!sendMessage(conn, reply)) {
+            logger_->error("Failed to send data to client");
+            handleClientDisconnect(conn);
+        }
+        return true;
+    }
+
+    //消息按订阅者收到的帧格式编码，只分配一次：本reactor直接投递，其他reactor通过任务队列拿到同一块缓冲区的引用
+    bool publish(std::string_view topic, std::string_view payload) {
+        static constexpr std::string_view PREFIX = "MSG ";
+        size_t body = PREFIX.size() + topic.size() + 1 + payload.size();
+        struct iovec header;
+        struct iovec trailer;
+        if (!codec_->encodeEnvelope(body, header, trailer)) {
+            return false;
+        }
+        metrics_.published++;
+
+        SharedBuffer wire = SharedBuffer::allocate(header.iov_len + body + trailer.iov_len);
+        char* p = wire.mutableData();
+        std::memcpy(p, header.iov_base, header.iov_len);
+        p += header.iov_len;
+        size_t topic_offset = header.iov_len + PREFIX.size();
+        std::memcpy(p, PREFIX.data(), PREFIX.size());
+        p += PREFIX.size();
+        std::memcpy(p, topic.data(), topic.size());
+        p += topic.size();
+        *p++ = ' ';
+        std::memcpy(p, payload.data(), payload.size());
+        p += payload.size();
+        std::memcpy(p, trailer.iov_base, trailer.iov_len);
+
+        size_t topic_len = topic.size();
+        for (Reactor* peer : peers_) {
+            if (peer == this) {
+                continue;
+            }
+            peer->post([peer, wire, topic_offset, topic_len] {
+                peer->deliver(wire, std::string_view(wire.data() + topic_offset, topic_len));
+            });
+        }
+        deliver(wire, std::string_view(wire.data() + topic_offset, topic_len));
+        return true;
+    }
+
+    //缓存命令按键的哈希高位选择分片：本reactor的分片就地执行；其他分片的命令拷贝一份投递给所属reactor，
+    //回复再投递回来，期间按转交处理，后续消息排队，回复顺序与请求一致；不是缓存命令时返回false
+    bool handleCache(Connection& conn, std::string_view message) {
+        std::string_view key;
+        if (!KvStore::parseKey(message, key)) {
+            return false;
+        }
+        size_t shard = peers_.size() > 1 ? (KvStore::hashKey(key) >> 32) % peers_.size() : shard_;
+        if (shard == shard_) {
+            std::string_view response = cache_->execute(message, now_ms_, scratch_);
+            if (!sendMessage(conn, response)) {
+                logger_->error("Failed to send data to client");
+                handleClientDisconnect(conn);
+            }
+            return true;
+        }
+
+        conn.setOffloading(true);
+        metrics_.cache_forwarded++;
+        Connection* target = &conn;
+        uint32_t generation = conn.generation();
+        uint64_t submitted = nowUs();
+        Reactor* owner = peers_[shard];
+        bool posted = owner->post([this, owner, target, generation, submitted, command = std::string(message)] {
+            std::string scratch;
+            std::string_view view = owner->executeCache(command, scratch);
+            std::string response = view.data() == scratch.data() ? std::move(scratch) : std::string(view);
+            post([this, target, generation, submitted, response = std::move(response)] {
+                completeOffload(*target, generation, submitted, response);
+            });
+        });
+        if (!posted) {
+            completeOffload(conn, generation, submitted, "ERR cache unavailable");
+        }
+        return true;
+    }
+
+    //结果通过任务队列回到本reactor线程写出；连接对象不会被释放，只需用generation确认它没有被复用
+    void offload(Connection& conn, std::string message) {
+        conn.setOffloading(true);
+        metrics_.offloaded++;
+        Connection* target = &conn;
+        uint32_t generation = conn.generation();
+        uint64_t submitted = nowUs();
+
+        workers_->submit([this, target, generation, submitted, message = std::move(message)] {
+            std::string scratch;
+            std::string_view view = handler_->handle(message, scratch);
+            std::string response = view.data() == scratch.data() ? std::move(scratch) : std::string(view);
+            post([this, target, generation, submitted, response = std::move(response)] {
+                completeOffload(*target, generation, submitted, response);
+            });
+        });
+    }
+
+    void completeOffload(Connection& conn, uint32_t generation, uint64_t submitted, std::string_view response) {
+        metrics_.offload_us.record(nowUs() - submitted);
+        if (conn.generation() != generation || conn.isClosed()) {
+            return;
+        }
+        conn.setOffloading(false);
+        if (!sendMessage(conn, response)) {
+            logger_->error("Failed to send data to client");
+            handleClientDisconnect(conn);
+            return;
+        }
+
+        //依次处理排队的消息，直到遇到下一条需要转交的
+        std::deque<std::string>& deferred = conn.deferred();
+        while (!deferred.empty() && !conn.isOffloading() && !conn.isClosed()) {
+            std::string message = std::move(deferred.front());
+            deferred.pop_front();
+            processMessage(conn, message);
+        }
+        if (conn.isClosed()) {
+            return;
+        }
+
+        if (conn.isReadingPaused() && canResumeReading(conn)) {
+            conn.setReadingPaused(false);
+        }
+        updateInterest(conn);
+    }
+
+    bool canResumeReading(Connection& conn) {
+        return conn.output().size() < OUTPUT_LOW_WATER && conn.deferred().size() < MAX_DEFERRED_MESSAGES / 2;
+    }
+
+    //编码后帧头与负载用一次writev发出，不拼接；写不完的部分才拷贝进发送队列
+    bool sendMessage(Connection& conn, std::string_view payload) {
+        struct iovec iov[3];
+        int cnt = codec_->encode(payload, iov);
+        std::span<struct iovec> pending(iov, static_cast<size_t>(cnt));
+
+        OutputQueue& output = conn.output();
+        if (output.empty()) {
+            ssize_t n = conn.socket().sendv(pending);
+            metrics_.write_calls++;
+            if (n < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    return false;
+                }
+                metrics_.write_eagain++;
+                n = 0;
+            }
+            metrics_.bytes_out += static_cast<uint64_t>(n);
+            pending = Socket::advance(pending, static_cast<size_t>(n));
+            if (!pending.empty()) {
+                metrics_.short_writes++;
+            }
+        }
+
+        for (const auto& seg : pending) {
+            output.append(static_cast<const char*>(seg.iov_base), seg.iov_len);
+        }
+        return true;
+    }
+
+    //文件回复：帧头/帧尾拷贝进发送队列，正文作为文件区间排在两者之间，由sendfile直接从页缓存发出
+    //发送队列原本为空时立即尝试发送，没发完的部分随EPOLLOUT从上次的偏移继续
+    bool sendFile(Connection& conn, const FileReply& file) {
+        struct iovec header;
+        struct iovec trailer;
+        if (!codec_->encodeEnvelope(file.length, header, trailer)) {
+            ::close(file.fd);
+            return false;
+        }
+
+        OutputQueue& output = conn.output();
+        bool was_empty = output.empty();
+        output.append(static_cast<const char*>(header.iov_base), header.iov_len);
+        output.appendFile(file.fd, file.offset, file.length);
+        output.append(static_cast<const char*>(trailer.iov_base), trailer.iov_len);
+        if (!was_empty) {
+            return true;
+        }
+
+        ssize_t n = output.flush(conn.socket());
+        metrics_.write_calls++;
+        if (n < 0) {
+            return false;
+        }
+        metrics_.bytes_out += static_cast<uint64_t>(n);
+        if (!output.empty()) {
+            metrics_.short_writes++;
+        }
+        return true;
+    }
+
+    //回显：发送队列为空时直接从输入缓冲写入套接字；写不完的部分连同缓冲块一起挂到发送队列
+    bool echo(Connection& conn) {
+        Socket& client_socket = conn.socket();
+        RingBuffer& input = conn.input();
+        OutputQueue& output = conn.output();
+
+        //已有排队数据时必须排在其后，保证字节顺序
+        if (output.empty()) {
+            ssize_t n = client_socket.send(input);
+            metrics_.write_calls++;
+            if (n < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    return false;
+                }
+                metrics_.write_eagain++;
+            } else {
+                metrics_.bytes_out += static_cast<uint64_t>(n);
+            }
+        }
+
+        if (!input.empty()) {
+            metrics_.short_writes++;
+            output.append(std::move(input));
+            input = RingBuffer(&pool_);
+        }
+        return true;
+    }
+
+    //EPOLLOUT就绪：继续发送排队数据，降到低水位以下时恢复读取
+    void handleClientWritable(Connection& conn) {
+        ssize_t sent = conn.output().flush(conn.socket());
+        metrics_.write_calls++;
+        if (sent < 0) {
+            logger_->error("Failed to send data to client");
+            handleClientDisconnect(conn);
+            return;
+        }
+        metrics_.bytes_out += static_cast<uint64_t>(sent);
+        if (conn.closeAfterFlush() && conn.output().empty()) {
+            handleClientDisconnect(conn);
+            return;
+        }
+        //有进展就把写超时往后推
+        if (sent > 0 && !conn.output().empty()) {
+            timers_.schedule(conn.writeTimer(), WRITE_TIMEOUT_MS);
+        }
+
+        if (conn.isReadingPaused() && canResumeReading(conn)) {
+            conn.setReadingPaused(false);
+        }
+        updateInterest(conn);
+    }
+
+    //只在发送队列非空时关注EPOLLOUT；暂停读取时去掉EPOLLIN
+    //边缘触发下重新加入EPOLLIN时，若内核中已有数据会立即再次通知
+    void updateInterest(Connection& conn) {
+        uint32_t events = EpollEvents::ET | EpollEvents::HUP | EpollEvents::ERR;
+        if (!conn.isReadingPaused()) {
+            events |= EpollEvents::IN;
+        }
+        if (!conn.output().empty()) {
+            events |= EpollEvents::OUT;
+        }
+
+        //写超时只在有数据排队时生效
+        if (conn.output().empty()) {
+            timers_.cancel(conn.writeTimer());
+        } else if (!conn.writeTimer().isScheduled()) {
+            timers_.schedule(conn.writeTimer(), WRITE_TIMEOUT_MS);
+        }
+
+        if (events != conn.interest()) {
+            if (!epoll_.modify(conn.fd(), events, &conn)) {
+                logger_->error("Failed to modify events in updateInterest()");
+                return;
+            }
+            conn.setInterest(events);
+        }
+    }
+
+    //收到数据时只记录时间，不移动定时器；到期时若期间有过活动，则按剩余时间重新调度
+    //订阅了主题的连接只收不发，不按空闲关闭
+    void handleIdleTimeout(Connection& conn) {
+        if (!conn.topics().empty()) {
+            timers_.schedule(conn.idleTimer(), IDLE_TIMEOUT_MS);
+            return;
+        }
+        uint64_t idle = now_ms_ - conn.lastActive();
+        if (idle < IDLE_TIMEOUT_MS) {
+            timers_.schedule(conn.idleTimer(), IDLE_TIMEOUT_MS - idle);
+            return;
+        }
+        logger_->info("Client idle for {} ms, closing", idle);
+        handleClientDisconnect(conn);
+    }
+
+    void handleWriteTimeout(Connection& conn) {
+        logger_->warn("Write timeout with {} byte(s) pending, closing", conn.output().size());
+        handleClientDisconnect(conn);
+    }
+
+    void handleClientError(Connection& conn) {
+        logger_->error("Connection Error");
+        handleClientDisconnect(conn);
+    }
+
+    void handleClientDisconnect(Connection& conn) {
+        if (conn.isClosed()) {
+            return;
+        }
+        if (clients_.find(conn.fd()) == &conn) {
+            if (!conn.isMetrics()) {
+                metrics_.closes++;
+            }
+            logger_->info("Client disconnected");
+            epoll_.remove(conn.fd());
+            timers_.cancel(conn.idleTimer());
+            timers_.cancel(conn.writeTimer());
+            conn.markClosed();
+            clients_.detach(conn.fd());
+            conn.socket().close();
+            closing_.push_back(&conn);
+            conn.abortSession();
+            closeUpstream(conn);
+            topics_.unsubscribeAll(&conn);
+        }
+    }
+
+    //会话协程的外壳：serve返回后写完已排队的数据再关闭；连接先被关闭时serve会随即以失败返回，不会跨越回收
+    Detached runSession(Connection& conn, uint32_t generation) {
+        co_await session_->serve(conn);
+        if (conn.generation() != generation || conn.isClosed()) {
+            co_return;
+        }
+        if (conn.output().empty()) {
+            handleClientDisconnect(conn);
+        } else {
+            conn.setCloseAfterFlush();
+        }
+    }
+
+    //会话连接的就绪事件：写出排队数据并在降到低水位后唤醒写等待者，可读时先读入再唤醒读等待者
+    //会话没有在等待读取时不读，数据留在内核中形成背压，下次read时取走
+    void handleSessionEvent(Connection& conn, uint32_t events) {
+        if (events & EpollEvents::OUT) {
+            handleClientWritable(conn);
+            if (conn.isClosed()) {
+                return;
+            }
+            if (conn.output().size() < OUTPUT_LOW_WATER) {
+                conn.resumeWriter();
+            }
+            if (conn.isClosed()) {
+                return;
+            }
+        }
+        if ((events & (EpollEvents::IN | EpollEvents::HUP | EpollEvents::ERR)) && conn.waitingForRead()) {
+            ssize_t n = sessionRead(conn);
+            if (n >= 0) {
+                conn.resumeReader(n);
+            }
+            if (conn.isClosed()) {
+                return;
+            }
+        }
+        if (events & EpollEvents::ERR) {
+            handleClientError(conn);
+        } else if (events & EpollEvents::HUP) {
+            handleClientDisconnect(conn);
+        }
+    }
+
+    //>0为读入的字节数，-1为暂无数据；对端关闭、出错或输入缓冲已满时返回0，连接交由会话结束后关闭
+    ssize_t sessionRead(Connection& conn) {
+        if (conn.isClosed()) {
+            return 0;
+        }
+        ssize_t n = conn.socket().recv(conn.input());
+        metrics_.read_calls++;
+        if (n > 0) {
+            conn.touch(now_ms_);
+            metrics_.bytes_in += static_cast<uint64_t>(n);
+            return n;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            metrics_.read_eagain++;
+            return -1;
+        }
+        return 0;
+    }
+
+    //发送队列为空时直接写，写不完的部分拷贝进发送队列并关注EPOLLOUT
+    bool sessionWrite(Connection& conn, std::string_view data, bool& backlogged) {
+        if (conn.isClosed()) {
+            return false;
+        }
+        OutputQueue& output = conn.output();
+        size_t written = 0;
+        if (output.empty() && !data.empty()) {
+            struct iovec iov = {const_cast<char*>(data.data()), data.size()};
+            ssize_t n = conn.socket().sendv(std::span<const struct iovec>(&iov, 1));
+            metrics_.write_calls++;
+            if (n < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    logger_->error("Failed to send data to client");
+                    handleClientDisconnect(conn);
+                    return false;
+                }
+                metrics_.write_eagain++;
+                n = 0;
+            }
+            metrics_.bytes_out += static_cast<uint64_t>(n);
+            written = static_cast<size_t>(n);
+            if (written < data.size()) {
+                metrics_.short_writes++;
+            }
+        }
+        if (written < data.size()) {
+            output.append(data.data() + written, data.size() - written);
+            updateInterest(conn);
+        }
+        backlogged = output.size() >= OUTPUT_HIGH_WATER;
+        return true;
+    }
+
+    //代理：为新连接选一个后端发起非阻塞连接，握手完成前客户端的数据留在内核中
+    void startProxy(Connection& conn) {
+        conn.link().attempts = 0;
+        if (!connectUpstream(conn)) {
+            logger_->error("No upstream available for {}", conn.peerName());
+            handleClientDisconnect(conn);
+        }
+    }
 
-    static const int MAX_EVENTS = 1024;
-    static const int PORT = 8080;
-    static const int BACKLOG = 128;
+    //按策略选后端，立即失败的换下一个；返回false表示全部后端都已试过
+    bool connectUpstream(Connection& conn) {
+        ProxyLink& link = conn.link();
+        while (link.attempts < upstreams_->size()) {
+            link.attempts++;
+            size_t index = upstreams_->pick(now_ms_);
+            bool pooled = false;
+            Socket upstream = upstreams_->connect(index, now_ms_, pooled);
+            metrics_.upstream_connects++;
+            if (!upstream.isValid()) {
+                metrics_.upstream_failures++;
+                logger_->warn("Failed to connect to upstream {}: {}", upstreams_->address(index).toString(),
+                              std::strerror(errno));
+                upstreams_->onFailure(index, now_ms_);
+                continue;
+            }
+            if (pooled) {
+                metrics_.upstream_pool_hits++;
+            }
 
-public:
-    EpollServer() : running_(false) {
-        try {
-            auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
-            auto file_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>("logs/server.log", true);
+            uint32_t events = EpollEvents::IN | EpollEvents::OUT | EpollEvents::ET | EpollEvents::HUP | EpollEvents::ERR;
+            if (!epoll_.add(upstream.getFd(), events, &link)) {
+                logger_->error("Failed to add upstream events");
+                continue;
+            }
+            link.upstream = std::move(upstream);
+            link.backend = index;
+            link.connecting = true;
+            upstreams_->onOpen(index);
+            timers_.schedule(link.connect_timer, config_.connect_timeout_ms);
+            return true;
+        }
+        return false;
+    }
 
-            std::vector<spdlog::sink_ptr> sinks {console_sink, file_sink};
-            logger_ = std::make_shared<spdlog::logger>("server_logger", sinks.begin(), sinks.end());
-            logger_->set_level(spdlog::level::info);
-            logger_->set_pattern("[%Y-%m-%d %H:%M:%S] [%l] %v");
+    //握手失败或超时：后端进入冷却期，换一个后端重试
+    void retryUpstream(Connection& conn, int error) {
+        size_t index = conn.link().backend;
+        metrics_.upstream_failures++;
+        logger_->warn("Upstream {} failed for {}: {}", upstreams_->address(index).toString(), conn.peerName(),
+                      std::strerror(error));
+        closeUpstream(conn);
+        upstreams_->onFailure(index, now_ms_);
+        if (!connectUpstream(conn)) {
+            logger_->error("No upstream available for {}", conn.peerName());
+            handleClientDisconnect(conn);
+        }
+    }
 
-            spdlog::register_logger(logger_);
-        } catch (const spdlog::spdlog_ex& ex) {
-            std::cerr <<"spdlog init failed" << ex.what() << std::endl;
+    void handleConnectTimeout(Connection& conn) {
+        if (!conn.isClosed() && conn.link().connecting) {
+            retryUpstream(conn, ETIMEDOUT);
         }
     }
 
-    ~EpollServer() {
-        stop();
+    //关闭后端一侧并归还管道；客户端连接关闭与回收时都会调用，重复调用无害
+    void closeUpstream(Connection& conn) {
+        ProxyLink& link = conn.link();
+        timers_.cancel(link.connect_timer);
+        if (link.upstream.isValid()) {
+            epoll_.remove(link.upstream.getFd());
+            link.upstream.close();
+            upstreams_->onClose(link.backend);
+        }
+        pipes_.release(link.inbound.pipe);
+        pipes_.release(link.outbound.pipe);
+        link.inbound = SpliceFlow();
+        link.outbound = SpliceFlow();
+        link.connecting = false;
     }
 
-    bool start() {
-        if (!server_socket_.createSocket()) {
-           logger_->error("Failed to create server socket");
-            return false;
+    //握手期间忽略客户端的可读通知，连上后一次抽空；边沿触发下数据不会因此丢失
+    void handleProxyClientEvent(Connection& conn, uint32_t events) {
+        ProxyLink& link = conn.link();
+        if (link.connecting) {
+            if (events & EpollEvents::ERR) {
+                handleClientError(conn);
+            }
+            return;
+        }
+        if ((events & (EpollEvents::IN | EpollEvents::HUP | EpollEvents::ERR)) &&
+            !pumpProxy(conn, link.inbound, conn.socket(), link.upstream)) {
+            return;
         }
+        if (events & EpollEvents::OUT) {
+            pumpProxy(conn, link.outbound, link.upstream, conn.socket());
+        }
+    }
 
-        if (!server_socket_.setNonBlocking()) {
-            logger_->error("Failed to set non blocking in start()");
-            return false;
+    //同一批事件中可能还有已换掉的旧后端套接字的通知，finishConnect查的是当前套接字，仍在握手时直接忽略
+    void handleUpstreamEvent(Connection& conn, uint32_t events) {
+        if (conn.isClosed()) {
+            return;
+        }
+        ProxyLink& link = conn.link();
+        if (link.connecting) {
+            int error = link.upstream.finishConnect();
+            if (error == EINPROGRESS) {
+                return;
+            }
+            if (error != 0) {
+                retryUpstream(conn, error);
+                return;
+            }
+            link.connecting = false;
+            timers_.cancel(link.connect_timer);
+            logger_->info("Proxying {} to {}", conn.peerName(), upstreams_->address(link.backend).toString());
+            //握手期间客户端发来的数据，以及后端可能已发出的欢迎信息
+            if (pumpProxy(conn, link.inbound, conn.socket(), link.upstream)) {
+                pumpProxy(conn, link.outbound, link.upstream, conn.socket());
+            }
+            return;
+        }
+        if ((events & EpollEvents::OUT) && !pumpProxy(conn, link.inbound, conn.socket(), link.upstream)) {
+            return;
+        }
+        if (events & (EpollEvents::IN | EpollEvents::HUP | EpollEvents::ERR)) {
+            pumpProxy(conn, link.outbound, link.upstream, conn.socket());
         }
+    }
+
+    //一个方向的转发：先把管道中的数据splice给to，再从from抽取新数据，直到to写满或from读空
+    //管道写满与from无数据都表现为EAGAIN，所以只有管道为空时from的EAGAIN才说明真的读空了
+    //from读到EOF且管道排空后向to转发FIN，两个方向都结束时关闭连接；返回false表示连接已关闭
+    bool pumpProxy(Connection& conn, SpliceFlow& flow, Socket& from, Socket& to) {
+        Pipe& pipe = flow.pipe;
+        while (true) {
+            if (pipe.buffered > 0) {
+                ssize_t n = to.spliceFrom(pipe.read_fd, pipe.buffered);
+                metrics_.write_calls++;
+                if (n < 0) {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        metrics_.write_eagain++;
+                        return true;
+                    }
+                    return failProxy(conn, "splice to peer");
+                }
+                pipe.buffered -= static_cast<size_t>(n);
+                metrics_.proxied_bytes += static_cast<uint64_t>(n);
+                conn.touch(now_ms_);
+            }
+
+            if (flow.eof) {
+                if (pipe.buffered > 0) {
+                    continue;
+                }
+                pipes_.release(pipe);
+                if (!flow.shut) {
+                    flow.shut = true;
+                    to.shutdownWrite();
+                }
+                ProxyLink& link = conn.link();
+                if (link.inbound.shut && link.outbound.shut) {
+                    handleClientDisconnect(conn);
+                    return false;
+                }
+                return true;
+            }
+
+            if (!pipe.isOpen() && !pipes_.acquire(pipe)) {
+                return failProxy(conn, "pipe2");
+            }
+            if (pipe.room() == 0) {
+                continue;
+            }
+            bool drained = pipe.buffered == 0;
+            ssize_t n = from.spliceTo(pipe.write_fd, pipe.room());
+            metrics_.read_calls++;
+            if (n > 0) {
+                pipe.buffered += static_cast<size_t>(n);
+            } else if (n == 0) {
+                flow.eof = true;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (drained) {
+                    metrics_.read_eagain++;
+                    pipes_.release(pipe);
+                    return true;
+                }
+            } else {
+                return failProxy(conn, "splice from peer");
+            }
+        }
+    }
+
+    bool failProxy(Connection& conn, const char* what) {
+        logger_->info("Proxy {} failed for {}: {}", what, conn.peerName(), std::strerror(errno));
+        handleClientDisconnect(conn);
+        return false;
+    }
+};
+
+#ifdef HAVE_IO_URING
+//基于io_uring完成通知的reactor：多发accept、使用缓冲环的多发recv，回显时直接发送内核填好的缓冲区
+//与EpollServer相比省去了"就绪通知 -> 再调用read"的往返，大部分情况下每个事件不再需要单独的系统调用
+class UringServer : public Reactor {
+private:
+    //待回显的一段数据，指向缓冲环中的某个缓冲区
+    struct PendingSend {
+        uint16_t bid;
+        uint32_t offset;
+        uint32_t len;
+    };
+
+    struct UringConnection {
+        Socket socket;
+        std::string peer_name;          //accept时取一次，之后写日志不再调用getpeername
+        std::deque<PendingSend> sends;  //队首正在发送，其余等待，保证字节顺序
+        int inflight = 0;               //在途的recv/send数，归零后才能关闭fd
+        bool recv_armed = false;
+        bool sending = false;
+        bool closing = false;
+
+        explicit UringConnection(int fd) : socket(fd) {}
+    };
+
+    enum Op : uint64_t {
+        OP_ACCEPT = 1,
+        OP_RECV = 2,
+        OP_SEND = 3,
+        OP_CANCEL = 4,
+        OP_WAKE = 5
+    };
+
+    //user_data高位存fd，低8位存操作类型；fd在全部在途操作完成前不会关闭，因此不会被复用
+    static uint64_t encode(int fd, Op op) { return (static_cast<uint64_t>(fd) << 8) | op; }
+
+    int id_;
+    ServerConfig config_;
+    Socket server_socket_;
+    Socket* listener_;
+    IoUring ring_;
+    ProvidedBufferRing buffers_;
+    std::vector<std::unique_ptr<UringConnection>> conns_;   //按fd下标索引
+    std::vector<int> stalled_;      //因缓冲区耗尽而停止接收的连接
+    bool recycled_;                 //本批处理中有缓冲区被归还
+    std::atomic<bool> running_;
+    TaskQueue tasks_;               //eventfd上始终挂着一个读请求，投递任务时完成
+    uint64_t wake_value_;
+    LoopMetrics metrics_;           //recv/send按完成事件计数
+    std::shared_ptr<AsyncLogger> logger_;
+
+    static const unsigned RING_ENTRIES = 4096;
+    static const unsigned BUFFER_COUNT = 4096;
+    static const size_t BUFFER_SIZE = 4096;
+    static const unsigned CQE_BATCH = 256;
+    //单个连接最多占用的未发出缓冲区数，超过后暂停接收，相当于EpollServer的高水位
+    static const size_t MAX_QUEUED_BUFFERS = 64;
+
+public:
+    //只监听config.listen中的第一个地址
+    UringServer(int id, const ServerConfig& config, std::shared_ptr<AsyncLogger> logger,
+                Socket* shared_listener = nullptr)
+        : id_(id), config_(config), listener_(shared_listener), recycled_(false), running_(false), wake_value_(0),
+          logger_(std::move(logger)) {}
+
+    ~UringServer() override {
+        stop();
+    }
 
-        if (!server_socket_.bindSocket(PORT)) {
-            logger_->error("Failed to bind socket");
+    bool start() override {
+        if (!ring_.init(RING_ENTRIES)) {
+            logger_->error("Failed to create io_uring");
             return false;
         }
 
-        if (!server_socket_.listenSocket(BACKLOG)) {
-            logger_->error("Failed to listen socket");
+        if (!buffers_.init(ring_, 0, BUFFER_COUNT, BUFFER_SIZE)) {
+            logger_->error("Failed to register io_uring buffer ring");
+            ring_.close();
             return false;
         }
 
-        if (!epoll_.create()) {
-            logger_->error("Failed to create epoll");
+        if (listener_ == nullptr) {
+            if (!openListener(server_socket_, config_.listen[0], config_.backlog, true, logger_, &config_)) {
+                return false;
+            }
+            listener_ = &server_socket_;
+        }
+
+        if (!armAccept()) {
+            logger_->error("Failed to submit accept");
             return false;
         }
 
-        if (!epoll_.add(server_socket_.getFd(), EpollEvents::IN | EpollEvents::ET)) {
-            logger_->error("Failed to add events in start()");
+        if (!tasks_.open() || !armWake()) {
+            logger_->error("Failed to register task queue");
             return false;
         }
 
-        logger_->info("Server started");
+        logger_->info("Reactor {} started (io_uring)", id_);
         running_ = true;
         return true;
     }
 
-    void run() {
+    void run() override {
+        struct io_uring_cqe* cqes[CQE_BATCH];
+
         while (running_) {
-            auto events = epoll_.wait();
-            if (events.empty() && !running_) {
+            if (ring_.submitAndWait(1) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
                 break;
             }
 
-            for (const auto& event : events) {
-                int fd = event.data.fd;
-                if (fd == server_socket_.getFd()) {
-                    handleNewConnection();
-                } else {
-                    if (event.events & EpollEvents::IN) {
-                        handleClientData(fd);
-                    }
-                    if (event.events & EpollEvents::ERR) {
-                        handleClientError(fd);
-                    }
-                    if (event.events & EpollEvents::HUP) {
-                        handleClientDisconnect(fd);
-                    }
+            uint64_t loop_start = nowUs();
+            uint64_t events = 0;
+            unsigned n;
+            while ((n = ring_.peekCqes(cqes, CQE_BATCH)) > 0) {
+                for (unsigned i = 0; i < n; i++) {
+                    handleCompletion(*cqes[i]);
                 }
+                ring_.advance(n);
+                events += n;
+            }
+
+            buffers_.commit();
+            if (recycled_) {
+                recycled_ = false;
+                rearmStalled();
             }
+            metrics_.wait_calls++;
+            metrics_.events += events;
+            metrics_.events_per_wait.record(events);
+            metrics_.loop_us.record(nowUs() - loop_start);
         }
     }
 
-    void stop() {
-        if (running_) {
+    void stop() override {
+        running_ = false;
+        if (!ring_.isValid()) {
+            return;
+        }
+        //先关闭ring：内核随之取消仍在途的多次accept/recv等请求，之后不会再有完成事件写入连接状态或缓冲区
+        //缓冲区注册随ring一起销毁，再释放连接和缓冲区内存
+        ring_.close();
+        conns_.clear();
+        stalled_.clear();
+        buffers_.close();
+        tasks_.close();
+        server_socket_.close();
+        logger_->info("Reactor {} stopped", id_);
+    }
+
+    bool post(TaskQueue::Task task) override {
+        return tasks_.post(std::move(task));
+    }
+
+    void shutdown() override {
+        if (!post([this] { running_ = false; })) {
             running_ = false;
-            for (auto& client : clients_) {
-                client.second->close();
+        }
+    }
+
+    void snapshotMetrics(LoopMetrics& out) override {
+        out = metrics_;
+        out.tasks = tasks_.executed();
+        for (const auto& conn : conns_) {
+            if (conn && !conn->closing) {
+                out.active_connections++;
+                if (!conn->recv_armed) {
+                    out.paused_connections++;
+                }
+                for (const auto& pending : conn->sends) {
+                    out.output_queue_bytes += pending.len - pending.offset;
+                }
             }
-            clients_.clear();
-            server_socket_.close();
-            epoll_.close();
-            logger_->info("Server stopped");
         }
     }
 
 private:
-    void handleNewConnection() {
-        while (true) {
-            Socket client_socket = server_socket_.acceptSocket();
+    bool armWake() {
+        struct io_uring_sqe* sqe = ring_.getSqe();
+        if (sqe == nullptr) {
+            return false;
+        }
+        IoUring::prepareRead(sqe, tasks_.getFd(), &wake_value_, sizeof(wake_value_), encode(0, OP_WAKE));
+        return true;
+    }
 
-            if (!client_socket.isValid()) {
+    bool armAccept() {
+        struct io_uring_sqe* sqe = ring_.getSqe();
+        if (sqe == nullptr) {
+            return false;
+        }
+        IoUring::prepareAccept(sqe, listener_->getFd(), true, encode(0, OP_ACCEPT));
+        return true;
+    }
+
+    bool armRecv(UringConnection& conn) {
+        struct io_uring_sqe* sqe = ring_.getSqe();
+        if (sqe == nullptr) {
+            return false;
+        }
+        int fd = conn.socket.getFd();
+        IoUring::prepareRecv(sqe, fd, buffers_.groupId(), true, encode(fd, OP_RECV));
+        conn.recv_armed = true;
+        conn.inflight++;
+        return true;
+    }
+
+    //同一连接同时只有一个send在途，部分发送时从剩余位置继续
+    void submitSend(UringConnection& conn) {
+        if (conn.sending || conn.sends.empty()) {
+            return;
+        }
+        struct io_uring_sqe* sqe = ring_.getSqe();
+        if (sqe == nullptr) {
+            closeConnection(conn);
+            return;
+        }
+        const PendingSend& front = conn.sends.front();
+        int fd = conn.socket.getFd();
+        IoUring::prepareSend(sqe, fd, buffers_.buffer(front.bid) + front.offset, front.len - front.offset, encode(fd, OP_SEND));
+        conn.sending = true;
+        conn.inflight++;
+    }
+
+    void recycle(uint16_t bid) {
+        buffers_.recycle(bid);
+        recycled_ = true;
+    }
+
+    void handleCompletion(const struct io_uring_cqe& cqe) {
+        Op op = static_cast<Op>(cqe.user_data & 0xff);
+        int fd = static_cast<int>(cqe.user_data >> 8);
+
+        switch (op) {
+            case OP_ACCEPT:
+                handleAccept(cqe);
+                break;
+            case OP_RECV:
+                if (fd >= 0 && static_cast<size_t>(fd) < conns_.size() && conns_[fd]) {
+                    handleRecv(*conns_[fd], cqe);
+                }
+                break;
+            case OP_SEND:
+                if (fd >= 0 && static_cast<size_t>(fd) < conns_.size() && conns_[fd]) {
+                    handleSend(*conns_[fd], cqe);
+                }
+                break;
+            case OP_CANCEL:
                 break;
+            case OP_WAKE:
+                tasks_.runPending();
+                if (running_ && !armWake()) {
+                    logger_->error("Failed to rearm task queue wakeup");
+                }
+                break;
+        }
+    }
+
+    void handleAccept(const struct io_uring_cqe& cqe) {
+        if (cqe.res >= 0) {
+            int fd = cqe.res;
+            if (static_cast<size_t>(fd) >= conns_.size()) {
+                conns_.resize(static_cast<size_t>(fd) + 1);
+            }
+            conns_[fd] = std::make_unique<UringConnection>(fd);
+            UringConnection& conn = *conns_[fd];
+            SocketAddress peer;
+            if (conn.socket.getPeerName(peer)) {
+                conn.peer_name = peer.toString();
             }
+            metrics_.accepts++;
+            logger_->info("New connection accepted from {}", conn.peer_name);
+            if (!armRecv(conn)) {
+                closeConnection(conn);
+                finalizeIfIdle(conn);
+            }
+        } else {
+            metrics_.accept_errors++;
+            logger_->error("accept failed: {}", std::strerror(-cqe.res));
+        }
 
-            int client_fd = client_socket.getFd();
+        //多发accept被内核终止（例如出错）时需要重新提交
+        if (!(cqe.flags & IORING_CQE_F_MORE) && running_) {
+            armAccept();
+        }
+    }
 
-            if (!client_socket.setNonBlocking(true)) {
-                logger_->error("Failed to set non blocking in handleNewConnection()");
-                client_socket.close();
-                continue;
+    void handleRecv(UringConnection& conn, const struct io_uring_cqe& cqe) {
+        bool more = cqe.flags & IORING_CQE_F_MORE;
+        if (!more) {
+            conn.recv_armed = false;
+            conn.inflight--;
+        }
+        metrics_.read_calls++;
+
+        if (cqe.res > 0) {
+            metrics_.bytes_in += static_cast<uint64_t>(cqe.res);
+            uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (conn.closing) {
+                recycle(bid);
+            } else {
+                logger_->debug("Received from {} : {}", conn.peer_name,
+                               std::string_view(buffers_.buffer(bid), static_cast<size_t>(cqe.res)));
+                conn.sends.push_back(PendingSend{bid, 0, static_cast<uint32_t>(cqe.res)});
+                submitSend(conn);
             }
+        } else if (cqe.res == 0) {
+            closeConnection(conn);
+        } else if (cqe.res == -ENOBUFS) {
+            //缓冲环暂时耗尽，等有缓冲区归还后再重新提交
+            if (!conn.closing) {
+                stalled_.push_back(conn.socket.getFd());
+            }
+        } else if (cqe.res != -ECANCELED) {
+            logger_->error("Connection Error");
+            closeConnection(conn);
+        }
 
-            if (!epoll_.add(client_fd, EpollEvents::IN | EpollEvents::ET | EpollEvents::HUP | EpollEvents::ERR)) {
-                logger_->error("Failed to add events in handleNewConnection()");
-                client_socket.close();
-                continue;
+        if (conn.closing) {
+            finalizeIfIdle(conn);
+        } else if (!conn.recv_armed && cqe.res != -ENOBUFS && conn.sends.size() < MAX_QUEUED_BUFFERS) {
+            armRecv(conn);
+        } else if (conn.recv_armed && conn.sends.size() >= MAX_QUEUED_BUFFERS) {
+            //对端读得慢：取消接收，让数据留在内核中形成背压
+            cancelRecv(conn);
+        }
+    }
+
+    void handleSend(UringConnection& conn, const struct io_uring_cqe& cqe) {
+        conn.sending = false;
+        conn.inflight--;
+
+        if (cqe.res < 0) {
+            if (!conn.closing) {
+                logger_->error("Failed to send data to client");
+                closeConnection(conn);
+            }
+        } else if (!conn.sends.empty()) {
+            metrics_.write_calls++;
+            metrics_.bytes_out += static_cast<uint64_t>(cqe.res);
+            PendingSend& front = conn.sends.front();
+            front.offset += static_cast<uint32_t>(cqe.res);
+            if (front.offset < front.len) {
+                metrics_.short_writes++;
+            }
+            if (front.offset >= front.len) {
+                recycle(front.bid);
+                conn.sends.pop_front();
+            }
+        }
+
+        if (conn.closing) {
+            finalizeIfIdle(conn);
+            return;
+        }
+
+        submitSend(conn);
+        if (!conn.recv_armed && conn.sends.size() < MAX_QUEUED_BUFFERS / 2) {
+            armRecv(conn);
+        }
+    }
+
+    void cancelRecv(UringConnection& conn) {
+        struct io_uring_sqe* sqe = ring_.getSqe();
+        if (sqe != nullptr) {
+            IoUring::prepareCancel(sqe, encode(conn.socket.getFd(), OP_RECV), encode(0, OP_CANCEL));
+        }
+    }
+
+    void rearmStalled() {
+        std::vector<int> stalled;
+        stalled.swap(stalled_);
+        for (int fd : stalled) {
+            if (static_cast<size_t>(fd) < conns_.size() && conns_[fd]) {
+                UringConnection& conn = *conns_[fd];
+                if (!conn.closing && !conn.recv_armed && conn.sends.size() < MAX_QUEUED_BUFFERS) {
+                    armRecv(conn);
+                }
             }
+        }
+    }
 
-            std::string peer_addr = client_socket.getPeerAddress();
-            int peer_port = client_socket.getPeerPort();
-            clients_[client_fd] = std::make_unique<Socket>(std::move(client_socket));
-            logger_->info("New connection accepted from {}:{}", peer_addr, peer_port);
+    //shutdown使在途的recv/send尽快完成，真正close要等全部在途操作结束
+    //调用方在不再访问conn之后调用finalizeIfIdle释放连接
+    void closeConnection(UringConnection& conn) {
+        if (conn.closing) {
+            return;
+        }
+        conn.closing = true;
+        metrics_.closes++;
+        logger_->info("Client disconnected");
+        ::shutdown(conn.socket.getFd(), SHUT_RDWR);
+        if (conn.recv_armed) {
+            cancelRecv(conn);
         }
     }
 
-    void handleClientData(int client_fd) {
-        auto it = clients_.find(client_fd);
-        if (it == clients_.end()) {
+    void finalizeIfIdle(UringConnection& conn) {
+        if (conn.inflight > 0) {
             return;
         }
+        for (const auto& pending : conn.sends) {
+            recycle(pending.bid);
+        }
+        int fd = conn.socket.getFd();
+        conns_[fd].reset();
+    }
+};
+#endif
 
-        Socket& client_socket = *it->second;
-        std::vector<char> buffer(4096);
+//多reactor服务器：每个线程运行一个EpollServer，新连接由内核分散到各个线程
+class MultiReactorServer {
+private:
+    ServerConfig config_;
+    int thread_count_;
+    Backend backend_;
+    std::vector<Socket> shared_sockets_;    //与config.listen下标对应，无效的项由各reactor自行打开
+    std::vector<std::string> unix_paths_;   //本进程创建的Unix套接字文件，stop时删除
+    std::vector<std::unique_ptr<Reactor>> reactors_;
+    std::vector<std::thread> threads_;
+    std::shared_ptr<MessageHandler> handler_;
+    std::shared_ptr<SessionHandler> session_;
+    std::unique_ptr<ThreadPool> workers_;   //所有reactor共用，须在reactor之前停止
+    std::shared_ptr<AsyncLogger> logger_;
 
-        while (true) {
-            ssize_t bytes_read = client_socket.recv(buffer, 4096);
+    //监听套接字、epoll、日志文件、备用fd等非连接用途预留的fd数
+    static const size_t RESERVED_FDS = 64;
 
-            if (bytes_read > 0) {
-                std::string recv_data(buffer.begin(), buffer.begin() + bytes_read);
-                std::string peer_addr = client_socket.getPeerAddress();
-                int peer_port = client_socket.getPeerPort();
-                logger_->info("Received from {}:{} : {}", peer_addr, peer_port, recv_data);
+public:
+    explicit MultiReactorServer(const ServerConfig& config)
+        : config_(config),
+          thread_count_(config.threads > 0 ? config.threads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()))),
+          backend_(config.backend),
+          logger_(std::make_shared<AsyncLogger>(createServerLogger(),
+                                                config.async_log ? AsyncLogger::Mode::Async : AsyncLogger::Mode::Sync)) {
+        logger_->setSampling(spdlog::level::info, config.info_sampling);
+    }
 
-                ssize_t bytes_sent = client_socket.send(recv_data);
-                if (bytes_sent < 0) {
-                    logger_->error("Failed to send data to client");
-                    handleClientDisconnect(client_fd);
-                    break;
-                }
-            } else if (bytes_read == 0) {
-                handleClientDisconnect(client_fd);
-                break;
-            } else if (bytes_read == -1) {
-                if (errno == EAGAIN && errno == EWOULDBLOCK) {
-                    break;
-                } else {
-                    handleClientError(client_fd);
+    ~MultiReactorServer() {
+        stop();
+    }
+
+    bool start() {
+        handler_ = createHandler(config_.handler);
+        if (!handler_) {
+            logger_->error("Unknown handler: {}", config_.handler);
+            return false;
+        }
+        if (!config_.session.empty()) {
+            session_ = createSession(config_.session);
+            if (!session_) {
+                logger_->error("Unknown session: {}", config_.session);
+                return false;
+            }
+        }
+
+        //发布订阅与缓存命令都建立在消息分帧之上，raw与http协议下无法识别，直接拒绝而不是静默忽略
+        bool framed = config_.protocol == Protocol::Line || config_.protocol == Protocol::LengthPrefixed;
+        if (!framed && (config_.pubsub || config_.cache)) {
+            logger_->error("{} requires line or length protocol", config_.pubsub ? "pubsub" : "cache");
+            return false;
+        }
+        //行分帧下文件正文只在末尾补一个换行，正文中的换行会打乱对端的分帧
+        if (handler_->servesFiles() && config_.protocol == Protocol::Line) {
+            logger_->error("{} handler cannot be used with line protocol, use length or http", handler_->name());
+            return false;
+        }
+
+        if (config_.worker_threads > 0) {
+            if (config_.protocol == Protocol::Raw) {
+                logger_->warn("Raw protocol has no message boundaries, worker pool disabled");
+            } else {
+                workers_ = std::make_unique<ThreadPool>(config_.worker_threads);
+                workers_->start();
+            }
+        }
+
+        //Exclusive模式共享全部监听套接字；Unix域套接字不能以SO_REUSEPORT重复绑定，任何模式下都只打开一次并共享
+        std::vector<Socket>* shared = nullptr;
+        shared_sockets_.resize(config_.listen.size());
+        for (size_t i = 0; i < config_.listen.size(); i++) {
+            const SocketAddress& address = config_.listen[i];
+            if (config_.listen_mode != ListenMode::Exclusive && !address.isUnix()) {
+                continue;
+            }
+            if (!openListener(shared_sockets_[i], address, config_.backlog, false, logger_, &config_)) {
+                logger_->error("Failed to create shared listener");
+                return false;
+            }
+            if (!address.unixPath().empty()) {
+                unix_paths_.push_back(address.unixPath());
+            }
+            shared = &shared_sockets_;
+        }
+
+        for (int i = 0; i < thread_count_; i++) {
+            std::unique_ptr<Reactor> reactor = createReactor(i, shared);
+            if (!reactor) {
+                logger_->error("Failed to start reactor {}", i);
+                return false;
+            }
+            reactors_.push_back(std::move(reactor));
+        }
+
+        //任何reactor上的/metrics请求都要汇总全部reactor
+        std::vector<Reactor*> peers;
+        for (auto& reactor : reactors_) {
+            peers.push_back(reactor.get());
+        }
+        for (auto& reactor : reactors_) {
+            reactor->setPeers(peers);
+        }
+
+        //由第一个支持的reactor提供指标页面；端口被占用等情况只告警，不影响服务
+        if (config_.metrics_port > 0) {
+            bool serving = false;
+            for (auto& reactor : reactors_) {
+                if (reactor->serveMetrics(config_.metrics_port)) {
+                    serving = true;
                     break;
                 }
             }
+            if (!serving) {
+                logger_->warn("Metrics endpoint unavailable on port {}", config_.metrics_port);
+            }
         }
+
+        logger_->info("Server started with {} reactor(s), listen mode: {}, backend: {}, handler: {}, workers: {}",
+                      thread_count_, config_.listen_mode == ListenMode::ReusePort ? "SO_REUSEPORT" : "EPOLLEXCLUSIVE",
+                      backend_ == Backend::IoUring ? "io_uring" : "epoll",
+                      mode(),
+                      workers_ ? workers_->size() : 0);
+        return true;
     }
 
-    void handleClientError(int client_fd) {
-        logger_->error("Connection Error");
-        handleClientDisconnect(client_fd);
+    //每个reactor在独立线程中运行，当前线程等待全部结束；配置了cpus时第i个reactor绑定到cpus[i % n]
+    //任何一个reactor退出（收到shutdown或自行出错停止）都让其余reactor一起退出，进程不会缺一个reactor继续运行
+    void run() {
+        for (size_t i = 0; i < reactors_.size(); i++) {
+            Reactor* r = reactors_[i].get();
+            threads_.emplace_back([this, r] {
+                r->run();
+                shutdown();
+            });
+            if (!config_.cpus.empty()) {
+                pinThread(threads_.back(), config_.cpus[i % config_.cpus.size()]);
+            }
+        }
+        for (auto& t : threads_) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+        threads_.clear();
     }
 
-    void handleClientDisconnect(int client_fd) {
-        auto it = clients_.find(client_fd);
-        if (it != clients_.end()) {
-            logger_->info("Client disconnected");
-            epoll_.remove(client_fd);
-            clients_.erase(it);
+    //任意线程调用，各reactor处理完当前一批事件后退出，run随之返回
+    void shutdown() {
+        for (auto& reactor : reactors_) {
+            reactor->shutdown();
         }
     }
-};
 
-volatile sig_atomic_t stop_server = 0;
+    void stop() {
+        if (workers_) {
+            workers_->stop();
+        }
+        if (reactors_.empty()) {
+            return;
+        }
+        for (auto& reactor : reactors_) {
+            reactor->stop();
+        }
+        reactors_.clear();
+        shared_sockets_.clear();
+        for (const auto& path : unix_paths_) {
+            ::unlink(path.c_str());
+        }
+        unix_paths_.clear();
+        logger_->info("Server stopped");
+        logger_->stop();
+    }
+
+private:
+    std::string mode() const {
+        if (!config_.upstreams.empty()) {
+            return "proxy to " + std::to_string(config_.upstreams.size()) + " upstream(s), " +
+                   (config_.balance == Balance::LeastConnections ? "least-conn" : "round-robin");
+        }
+        return session_ ? std::string("session ") + session_->name() : std::string(handler_->name());
+    }
+
+    void pinThread(std::thread& thread, int cpu) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        int rc = pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+        if (rc != 0) {
+            logger_->warn("Failed to pin reactor thread to cpu {}: {}", cpu, std::strerror(rc));
+        }
+    }
 
-void signalHandler(int signum) {
-    std::cout << "\nReceived signal: " << signum << std::endl;
-    stop_server = 1;
-}
+    //总上限平均分到各reactor；未指定时以fd软上限为准，使正常情况下不会走到EMFILE
+    size_t perReactorLimit() const {
+        size_t total = config_.max_connections;
+        if (total == 0) {
+            struct rlimit limit;
+            if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY) {
+                return SIZE_MAX;
+            }
+            size_t nofile = static_cast<size_t>(limit.rlim_cur);
+            total = nofile > RESERVED_FDS * 2 ? nofile - RESERVED_FDS : nofile / 2;
+            //代理的每个连接另占一个后端fd，中转管道只在数据在途时占用，不计入
+            if (!config_.upstreams.empty()) {
+                total /= 2;
+            }
+        }
+        return std::max<size_t>(1, total / static_cast<size_t>(thread_count_));
+    }
 
-int main() {
-    signal(SIGINT, signalHandler);
-    signal(SIGTERM, signalHandler);
+    //内核不支持io_uring（或被seccomp禁用）时回退到epoll
+    std::unique_ptr<Reactor> createReactor(int id, std::vector<Socket>* shared) {
+#ifdef HAVE_IO_URING
+        //io_uring后端目前只实现了原样回显，且只监听第一个地址
+        if (backend_ == Backend::IoUring &&
+            (config_.protocol != Protocol::Raw || workers_ || session_ || !config_.upstreams.empty())) {
+            logger_->warn("io_uring backend only supports raw echo, using epoll");
+            backend_ = Backend::Epoll;
+        }
+        if (backend_ == Backend::IoUring) {
+            if (config_.listen.size() > 1) {
+                logger_->warn("io_uring backend only listens on {}", config_.listen[0].toString());
+            }
+            Socket* listener = shared != nullptr && (*shared)[0].isValid() ? &(*shared)[0] : nullptr;
+            auto reactor = std::make_unique<UringServer>(id, config_, logger_, listener);
+            if (reactor->start()) {
+                return reactor;
+            }
+            logger_->warn("io_uring unavailable, reactor {} falls back to epoll", id);
+            backend_ = Backend::Epoll;
+        }
+#else
+        if (backend_ == Backend::IoUring) {
+            logger_->warn("Built without io_uring support, using epoll");
+            backend_ = Backend::Epoll;
+        }
+#endif
+        auto reactor = std::make_unique<EpollServer>(id, config_, logger_, shared, perReactorLimit(), handler_,
+                                                     workers_.get(), session_);
+        if (!reactor->start()) {
+            return nullptr;
+        }
+        return reactor;
+    }
+};
+
+//用法见printUsage：server --config 文件 --键 值 ...，也兼容旧的位置参数
+int main(int argc, char* argv[]) {
     signal(SIGPIPE, SIG_IGN);
 
-    EpollServer server;
+    ServerConfig config;
+    if (!parseCommandLine(argc, argv, config)) {
+        return argc >= 2 && (std::string(argv[1]) == "--help" || std::string(argv[1]) == "-h") ? 0 : -1;
+    }
+
+    //在创建任何线程之前屏蔽SIGINT/SIGTERM，由专门的线程sigwait后通过任务队列通知各reactor退出
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    MultiReactorServer server(config);
 
     if (!server.start()) {
         std::cerr << "Error starting server" << std::endl;
@@ -226,10 +2545,22 @@ int main() {
 
     std::cout << "Server is running..." << std::endl;
 
+    std::thread signal_waiter([&server, &signals] {
+        int signum = 0;
+        if (sigwait(&signals, &signum) == 0) {
+            std::cout << "\nReceived signal: " << signum << std::endl;
+        }
+        server.shutdown();
+    });
+
     server.run();
 
+    //reactor也可能自行退出，此时给等待线程补一个信号让它结束
+    pthread_kill(signal_waiter.native_handle(), SIGTERM);
+    signal_waiter.join();
+
     server.stop();
     std::cout << "Server stopped" << std::endl;
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,316 @@
+#include "../../include/server_config.h"
+
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <thread>
+
+namespace {
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\r')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+template <typename T>
+bool parseNumber(std::string_view text, T& out) {
+    const char* end = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), end, out);
+    return ec == std::errc() && ptr == end && !text.empty();
+}
+
+bool parseBool(std::string_view text, bool& out) {
+    if (text == "1" || text == "on" || text == "true" || text == "yes") {
+        out = true;
+        return true;
+    }
+    if (text == "0" || text == "off" || text == "false" || text == "no") {
+        out = false;
+        return true;
+    }
+    return false;
+}
+
+//地址格式见SocketAddress；TCP地址必须给出非0端口
+bool parseListen(std::string_view text, SocketAddress& out) {
+    SocketAddress addr;
+    if (!SocketAddress::parse(text, addr) || (addr.isInet() && addr.port() == 0)) {
+        return false;
+    }
+    out = addr;
+    return true;
+}
+
+//后端地址必须可以连接：不接受通配地址
+bool parseUpstream(std::string_view text, SocketAddress& out) {
+    SocketAddress addr;
+    if (!SocketAddress::parse(text, addr) || addr.isWildcard() || (addr.isInet() && addr.port() == 0)) {
+        return false;
+    }
+    out = addr;
+    return true;
+}
+
+//逗号分隔的列表，逐项交给parse
+template <typename T, typename F>
+bool parseList(std::string_view text, std::vector<T>& out, F parse) {
+    std::vector<T> items;
+    while (!text.empty()) {
+        size_t comma = text.find(',');
+        T item;
+        if (!parse(trim(text.substr(0, comma)), item)) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        text.remove_prefix(comma + 1);
+    }
+    if (items.empty()) {
+        return false;
+    }
+    out = std::move(items);
+    return true;
+}
+
+bool parseCpus(std::string_view text, std::vector<int>& out) {
+    if (text == "none") {
+        out.clear();
+        return true;
+    }
+    if (text == "auto") {
+        out.clear();
+        unsigned n = std::thread::hardware_concurrency();
+        for (unsigned i = 0; i < n; i++) {
+            out.push_back(static_cast<int>(i));
+        }
+        return true;
+    }
+    return parseList(text, out, [](std::string_view item, int& cpu) { return parseNumber(item, cpu) && cpu >= 0; });
+}
+
+//旧的位置参数依次对应的键
+const char* const POSITIONAL_KEYS[] = {"threads", "listen-mode", "backend", "protocol", "log",
+                                       "info-sample", "handler", "workers", "metrics-port"};
+
+}
+
+bool setConfigOption(ServerConfig& config, const std::string& key, const std::string& value) {
+    std::string_view v = trim(value);
+    bool ok = true;
+
+    if (key == "threads") {
+        ok = parseNumber(v, config.threads) && config.threads >= 0;
+    } else if (key == "listen") {
+        ok = parseList(v, config.listen, parseListen);
+    } else if (key == "backlog") {
+        ok = parseNumber(v, config.backlog) && config.backlog > 0;
+    } else if (key == "events-per-wait") {
+        ok = parseNumber(v, config.events_per_wait) && config.events_per_wait > 0;
+    } else if (key == "listen-mode") {
+        ok = v == "reuseport" || v == "exclusive";
+        config.listen_mode = v == "exclusive" ? ListenMode::Exclusive : ListenMode::ReusePort;
+    } else if (key == "backend") {
+        ok = v == "epoll" || v == "uring";
+        config.backend = v == "uring" ? Backend::IoUring : Backend::Epoll;
+    } else if (key == "protocol") {
+        if (v == "raw") {
+            config.protocol = Protocol::Raw;
+        } else if (v == "length") {
+            config.protocol = Protocol::LengthPrefixed;
+        } else if (v == "line") {
+            config.protocol = Protocol::Line;
+        } else if (v == "http") {
+            config.protocol = Protocol::Http;
+        } else {
+            ok = false;
+        }
+    } else if (key == "log") {
+        ok = v == "async" || v == "sync";
+        config.async_log = v != "sync";
+    } else if (key == "info-sample") {
+        ok = parseNumber(v, config.info_sampling) && config.info_sampling > 0;
+    } else if (key == "handler") {
+        config.handler = std::string(v);
+        ok = !v.empty();
+    } else if (key == "session") {
+        config.session = v == "none" ? std::string() : std::string(v);
+    } else if (key == "workers") {
+        ok = parseNumber(v, config.worker_threads);
+    } else if (key == "metrics-port") {
+        ok = parseNumber(v, config.metrics_port) && config.metrics_port >= 0 && config.metrics_port <= 65535;
+    } else if (key == "upstream") {
+        if (v == "none") {
+            config.upstreams.clear();
+        } else {
+            ok = parseList(v, config.upstreams, parseUpstream);
+        }
+    } else if (key == "balance") {
+        ok = v == "round-robin" || v == "least-conn";
+        config.balance = v == "least-conn" ? Balance::LeastConnections : Balance::RoundRobin;
+    } else if (key == "upstream-pool") {
+        ok = parseNumber(v, config.upstream_pool);
+    } else if (key == "connect-timeout") {
+        ok = parseNumber(v, config.connect_timeout_ms) && config.connect_timeout_ms > 0;
+    } else if (key == "pubsub") {
+        ok = parseBool(v, config.pubsub);
+    } else if (key == "subscriber-queue") {
+        ok = parseNumber(v, config.subscriber_queue) && config.subscriber_queue > 0;
+    } else if (key == "slow-subscriber") {
+        ok = v == "drop" || v == "disconnect";
+        config.slow_subscriber = v == "disconnect" ? SlowSubscriber::Disconnect : SlowSubscriber::Drop;
+    } else if (key == "cache") {
+        ok = parseBool(v, config.cache);
+    } else if (key == "cache-memory") {
+        ok = parseNumber(v, config.cache_memory) && config.cache_memory > 0;
+    } else if (key == "max-connections") {
+        ok = parseNumber(v, config.max_connections);
+    } else if (key == "sndbuf") {
+        ok = parseNumber(v, config.send_buffer) && config.send_buffer >= 0;
+    } else if (key == "rcvbuf") {
+        ok = parseNumber(v, config.receive_buffer) && config.receive_buffer >= 0;
+    } else if (key == "nodelay") {
+        ok = parseBool(v, config.tcp_nodelay);
+    } else if (key == "defer-accept") {
+        ok = parseNumber(v, config.defer_accept) && config.defer_accept >= 0;
+    } else if (key == "fastopen") {
+        ok = parseNumber(v, config.fastopen) && config.fastopen >= 0;
+    } else if (key == "busy-poll") {
+        ok = parseNumber(v, config.busy_poll) && config.busy_poll >= 0;
+    } else if (key == "cpus") {
+        ok = parseCpus(v, config.cpus);
+    } else {
+        std::cerr << "Unknown option: " << key << std::endl;
+        return false;
+    }
+
+    if (!ok) {
+        std::cerr << "Invalid value for " << key << ": " << value << std::endl;
+    }
+    return ok;
+}
+
+bool loadConfigFile(const std::string& path, ServerConfig& config) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Cannot open config file: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int line_no = 0;
+    while (std::getline(in, line)) {
+        line_no++;
+        std::string_view text = line;
+        text = trim(text.substr(0, text.find('#')));
+        if (text.empty()) {
+            continue;
+        }
+        size_t eq = text.find('=');
+        if (eq == std::string_view::npos) {
+            std::cerr << path << ":" << line_no << ": expected key = value" << std::endl;
+            return false;
+        }
+        if (!setConfigOption(config, std::string(trim(text.substr(0, eq))), std::string(text.substr(eq + 1)))) {
+            std::cerr << path << ":" << line_no << ": rejected" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parseCommandLine(int argc, char* argv[], ServerConfig& config) {
+    if (argc >= 2 && argv[1][0] != '-') {
+        size_t count = sizeof(POSITIONAL_KEYS) / sizeof(POSITIONAL_KEYS[0]);
+        if (static_cast<size_t>(argc - 1) > count) {
+            printUsage(std::cerr, argv[0]);
+            return false;
+        }
+        for (int i = 1; i < argc; i++) {
+            if (!setConfigOption(config, POSITIONAL_KEYS[i - 1], argv[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //先拆出全部键值对，配置文件先加载，命令行上的其他选项再覆盖它
+    std::vector<std::pair<std::string, std::string>> options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(std::cout, argv[0]);
+            return false;
+        }
+        if (arg.rfind("--", 0) != 0) {
+            std::cerr << "Unexpected argument: " << arg << std::endl;
+            printUsage(std::cerr, argv[0]);
+            return false;
+        }
+        arg = arg.substr(2);
+        size_t eq = arg.find('=');
+        if (eq != std::string::npos) {
+            options.emplace_back(arg.substr(0, eq), arg.substr(eq + 1));
+        } else if (i + 1 < argc) {
+            options.emplace_back(arg, argv[++i]);
+        } else {
+            std::cerr << "Missing value for --" << arg << std::endl;
+            return false;
+        }
+    }
+
+    for (const auto& [key, value] : options) {
+        if (key == "config" && !loadConfigFile(value, config)) {
+            return false;
+        }
+    }
+    for (const auto& [key, value] : options) {
+        if (key != "config" && !setConfigOption(config, key, value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void printUsage(std::ostream& out, const char* program) {
+    out << "Usage: " << program << " [--config FILE] [--KEY VALUE ...]\n"
+        << "       " << program << " [threads] [reuseport|exclusive] [epoll|uring] [raw|length|line|http] [async|sync]\n"
+        << "              [info-sample] [echo|checksum|file[:DIR]] [workers] [metrics-port]\n"
+        << "Keys (also valid in the config file as KEY = VALUE):\n"
+        << "  threads N            reactor threads, 0 = number of CPUs\n"
+        << "  listen ADDR[,ADDR]   HOST:PORT, [V6]:PORT, PORT or unix:PATH; default 8080 dual-stack\n"
+        << "  backlog N            listen backlog (128)\n"
+        << "  events-per-wait N    epoll_wait batch size (1024)\n"
+        << "  listen-mode M        reuseport | exclusive\n"
+        << "  backend B            epoll | uring\n"
+        << "  protocol P           raw | length | line | http\n"
+        << "  log M                async | sync\n"
+        << "  info-sample N        keep 1 of N info logs\n"
+        << "  handler H            echo | checksum | file[:DIR]\n"
+        << "  session S            coroutine session per connection: echo | delay | none\n"
+        << "  workers N            worker pool threads for offloaded messages\n"
+        << "  metrics-port N       Prometheus endpoint port, 0 = off (9100)\n"
+        << "  max-connections N    total connection limit, 0 = derive from RLIMIT_NOFILE\n"
+        << "  upstream ADDR[,ADDR] proxy every connection to these backends, none = off\n"
+        << "  balance B            round-robin | least-conn\n"
+        << "  upstream-pool N      pre-connected idle connections per backend and reactor (2)\n"
+        << "  connect-timeout MS   upstream connect timeout (3000)\n"
+        << "  pubsub on|off        SUB/UNSUB/PUB commands on length or line framing\n"
+        << "  subscriber-queue N   send queue bytes before a subscriber counts as slow (1048576)\n"
+        << "  slow-subscriber P    drop | disconnect\n"
+        << "  cache on|off         GET/SET/DEL/TTL key-value commands on length or line framing\n"
+        << "  cache-memory N       cache memory limit in bytes across all reactors (67108864)\n"
+        << "  sndbuf N / rcvbuf N  socket buffer sizes in bytes, 0 = kernel default\n"
+        << "  nodelay on|off       TCP_NODELAY\n"
+        << "  defer-accept SEC     TCP_DEFER_ACCEPT, 0 = off\n"
+        << "  fastopen N           TCP_FASTOPEN queue length, 0 = off\n"
+        << "  busy-poll USEC       SO_BUSY_POLL, 0 = off\n"
+        << "  cpus LIST|auto|none  pin reactor i to cpus[i % n]\n";
+}
@@ -0,0 +1,102 @@
+#include "../../include/session.h"
+#include "../../include/buffer.h"
+#include "../../include/codec.h"
+
+#include <algorithm>
+#include <charconv>
+
+#include <sys/uio.h>
+
+void CoStream::SleepAwaiter::await_suspend(std::coroutine_handle<> h) {
+    CoStream* stream = &stream_;
+    timer_.setCallback([stream] { stream->wake(Wait::Sleep, 1); });
+    stream_.sleep_timer_ = &timer_;
+    stream_.suspend(Wait::Sleep, h);
+    stream_.scheduleTimer(timer_, ms_);
+}
+
+void CoStream::wake(Wait kind, ssize_t result) {
+    if (waiting_ != kind) {
+        return;
+    }
+    std::coroutine_handle<> h = waiter_;
+    waiter_ = nullptr;
+    waiting_ = Wait::None;
+    sleep_timer_ = nullptr;
+    result_ = result;
+    h.resume();
+}
+
+void CoStream::abortWaiter() {
+    if (waiting_ == Wait::None) {
+        return;
+    }
+    if (waiting_ == Wait::Sleep && sleep_timer_ != nullptr) {
+        cancelTimer(*sleep_timer_);
+    }
+    wake(waiting_, 0);
+}
+
+Task<> EchoSession::serve(CoStream& stream) const {
+    RingBuffer& input = stream.input();
+    while (co_await stream.read() > 0) {
+        struct iovec iov[2];
+        int cnt = input.readableSegments(iov);
+        for (int i = 0; i < cnt; i++) {
+            if (!co_await stream.write(std::string_view(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len))) {
+                co_return;
+            }
+        }
+        input.consume(input.readable());
+    }
+}
+
+Task<> DelaySession::serve(CoStream& stream) const {
+    RingBuffer& input = stream.input();
+    DelimiterCodec codec(MAX_LINE, '\n');
+    Frame frame;
+    std::string reply;
+
+    while (co_await stream.read() > 0) {
+        while (true) {
+            FrameCodec::DecodeResult result = codec.decode(input, frame);
+            if (result == FrameCodec::DecodeResult::NeedMore) {
+                break;
+            }
+            if (result == FrameCodec::DecodeResult::Error) {
+                co_await stream.write("ERR line too long\n");
+                co_return;
+            }
+
+            //行视图在处理期间一直有效：会话不读取时输入缓冲不会变化
+            std::string_view line = frame.payload;
+            size_t space = line.find(' ');
+            std::string_view number = line.substr(0, space);
+            std::string_view text = space == std::string_view::npos ? std::string_view() : line.substr(space + 1);
+            uint64_t ms = 0;
+            auto [ptr, ec] = std::from_chars(number.data(), number.data() + number.size(), ms);
+            bool ok = ec == std::errc() && ptr == number.data() + number.size() && !number.empty();
+
+            if (ok && !co_await stream.sleep(std::min(ms, MAX_DELAY_MS))) {
+                co_return;
+            }
+            //回复连同换行一次写出，省一次系统调用
+            reply.assign(ok ? text : "ERR");
+            reply.push_back('\n');
+            if (!co_await stream.write(reply)) {
+                co_return;
+            }
+            input.consume(frame.wire_size);
+        }
+    }
+}
+
+std::unique_ptr<SessionHandler> createSession(const std::string& name) {
+    if (name == "echo") {
+        return std::make_unique<EchoSession>();
+    }
+    if (name == "delay") {
+        return std::make_unique<DelaySession>();
+    }
+    return nullptr;
+}
@@ -0,0 +1,111 @@
+#include "../../include/upstream.h"
+
+#include <cerrno>
+
+#include <sys/socket.h>
+
+UpstreamGroup::UpstreamGroup(const std::vector<SocketAddress>& backends, Balance balance, size_t pool_size)
+    : backends_(backends.size()), balance_(balance), pool_size_(pool_size) {
+    for (size_t i = 0; i < backends.size(); i++) {
+        backends_[i].address = backends[i];
+    }
+}
+
+size_t UpstreamGroup::pick(uint64_t now_ms) {
+    size_t n = backends_.size();
+    bool all_down = true;
+    for (const Backend& backend : backends_) {
+        if (!isDown(backend, now_ms)) {
+            all_down = false;
+            break;
+        }
+    }
+
+    if (balance_ == Balance::LeastConnections) {
+        //从轮询位置开始比较，连接数相同的后端轮流被选中
+        size_t best = n;
+        for (size_t k = 0; k < n; k++) {
+            size_t i = (next_ + k) % n;
+            if (!all_down && isDown(backends_[i], now_ms)) {
+                continue;
+            }
+            if (best == n || backends_[i].active < backends_[best].active) {
+                best = i;
+            }
+        }
+        next_ = (best + 1) % n;
+        return best;
+    }
+
+    for (size_t k = 0; k < n; k++) {
+        size_t i = next_;
+        next_ = (next_ + 1) % n;
+        if (all_down || !isDown(backends_[i], now_ms)) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+Socket UpstreamGroup::connect(size_t index, uint64_t now_ms, bool& pooled) {
+    Backend& backend = backends_[index];
+    pooled = false;
+    while (!backend.pool.empty()) {
+        Pooled entry = std::move(backend.pool.front());
+        backend.pool.pop_front();
+        if (now_ms - entry.created_ms <= POOL_MAX_IDLE_MS && isUsable(entry.socket)) {
+            pooled = true;
+            refill(backend, now_ms);
+            return std::move(entry.socket);
+        }
+    }
+
+    Socket socket;
+    if (!socket.connectNonBlocking(backend.address)) {
+        return Socket();
+    }
+    refill(backend, now_ms);
+    return socket;
+}
+
+void UpstreamGroup::refill(uint64_t now_ms) {
+    for (Backend& backend : backends_) {
+        refill(backend, now_ms);
+    }
+}
+
+void UpstreamGroup::refill(Backend& backend, uint64_t now_ms) {
+    if (isDown(backend, now_ms)) {
+        return;
+    }
+    while (backend.pool.size() < pool_size_) {
+        Socket socket;
+        if (!socket.connectNonBlocking(backend.address)) {
+            return;
+        }
+        backend.pool.push_back(Pooled{std::move(socket), now_ms});
+    }
+}
+
+void UpstreamGroup::onClose(size_t index) {
+    if (backends_[index].active > 0) {
+        backends_[index].active--;
+    }
+}
+
+void UpstreamGroup::onFailure(size_t index, uint64_t now_ms) {
+    backends_[index].down_until_ms = now_ms + FAILURE_COOLDOWN_MS;
+    backends_[index].pool.clear();
+}
+
+//握手失败的SO_ERROR非0；已连上的用MSG_PEEK探测，读到0说明后端已经关闭了这条连接
+//仍在握手的套接字上recv返回EAGAIN，与已连上但没有数据的一样视为可用
+bool UpstreamGroup::isUsable(Socket& socket) {
+    int error = socket.finishConnect();
+    if (error != 0 && error != EINPROGRESS) {
+        return false;
+    }
+    char byte;
+    ssize_t n = ::recv(socket.getFd(), &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+}